@@ -0,0 +1,135 @@
+// Microbenchmark of packing_set against the std::map version it replaced,
+// on random updates (add, remove or a new lowerbound) each followed by a
+// query, as incremental_lower_bound does. Both must give the same answers.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "../src/datastructures/packing-set.h"
+
+// The reference: the values in a map, walked from the largest value down
+// on every query after an update.
+class map_packing_set {
+public:
+	void add(int c) {
+		values[c]++;
+		ps_size = -1;
+	}
+
+	void remove(int c) {
+		auto it = values.find(c);
+		it->second--;
+		if (it->second == 0)
+			values.erase(it);
+		ps_size = -1;
+	}
+
+	void set_lower_bound(int nC) {
+		C = nC;
+		ps_size = -1;
+	}
+
+	int get_minimum_packing_set_size() {
+		if (ps_size == -1) {
+			int ps = 0;
+			ps_size = 0;
+			for (auto it = values.rbegin(); ps < C && it != values.rend();
+					++it) {
+				int use = std::min(it->second,
+					(C - ps + it->first - 1) / it->first);
+				ps_size += use;
+				ps += use * it->first;
+			}
+		}
+		return ps_size;
+	}
+
+private:
+	std::map<int, int> values;
+	int C = 0, ps_size = -1;
+};
+
+enum class op_type { add, remove, bound };
+struct op {
+	op_type type;
+	int value;
+};
+
+// Number of values in the set at the start, and of operations timed.
+constexpr int START = 1000, OPS = 1000000;
+
+// Generate OPS operations on values in [1, max_value], keeping the set
+// around START values, with the lowerbound somewhere below the total.
+std::vector<op> generate(int max_value, std::mt19937 &rng) {
+	std::vector<op> ops;
+	std::vector<int> present;
+	long long total = 0;
+	for (int i = 0; i < START; ++i) {
+		int c = 1 + (int)(rng() % max_value);
+		ops.push_back({op_type::add, c});
+		present.push_back(c);
+		total += c;
+	}
+	for (int i = 0; i < OPS; ++i) {
+		int kind = (int)(rng() % 3);
+		if (kind == 0 || present.empty()) {
+			int c = 1 + (int)(rng() % max_value);
+			ops.push_back({op_type::add, c});
+			present.push_back(c);
+			total += c;
+		} else if (kind == 1) {
+			size_t j = rng() % present.size();
+			ops.push_back({op_type::remove, present[j]});
+			total -= present[j];
+			present[j] = present.back();
+			present.pop_back();
+		} else {
+			ops.push_back({op_type::bound, (int)(rng() % (total + 1))});
+		}
+	}
+	return ops;
+}
+
+// Apply the operations, querying after each, and return the time taken per
+// timed operation in ns. The answers are written to out.
+template <class T>
+double run(T &ps, const std::vector<op> &ops, std::vector<int> &out) {
+	out.assign(ops.size(), 0);
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < ops.size(); ++i) {
+		if (i == START)
+			start = std::chrono::steady_clock::now();
+		switch (ops[i].type) {
+			case op_type::add: ps.add(ops[i].value); break;
+			case op_type::remove: ps.remove(ops[i].value); break;
+			case op_type::bound: ps.set_lower_bound(ops[i].value); break;
+		}
+		out[i] = ps.get_minimum_packing_set_size();
+	}
+	return std::chrono::duration<double, std::nano>(
+		std::chrono::steady_clock::now() - start).count() / OPS;
+}
+
+int main() {
+	std::mt19937 rng(1);
+	bool ok = true;
+	printf("%8s %16s %16s\n", "Cmax", "map (ns/op)", "fenwick (ns/op)");
+	for (int max_value : {16, 100, 1000, 10000}) {
+		std::vector<op> ops = generate(max_value, rng);
+		std::vector<int> expected, found;
+		map_packing_set reference;
+		double map_ns = run(reference, ops, expected);
+		mp::packing_set ps(max_value);
+		double fenwick_ns = run(ps, ops, found);
+		printf("%8d %16.1f %16.1f\n", max_value, map_ns, fenwick_ns);
+		if (found != expected) {
+			printf("FAILED: answers differ for Cmax = %d\n", max_value);
+			ok = false;
+		}
+	}
+	return ok ? 0 : 1;
+}
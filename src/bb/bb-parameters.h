@@ -6,6 +6,17 @@
 
 namespace mp {
 
+// Initial order of the rows/columns for branching. The order also decides
+// ties when picking the next row/column to branch on.
+enum class branch_order {
+	// By decreasing number of nonzeros.
+	degree,
+	// By decreasing number of nonzeros, with ties broken randomly.
+	shuffled_degree,
+	// Uniformly random.
+	random
+};
+
 struct bbparameters {
 	const bool
 		// Whether or not to use the packing bound.
@@ -21,8 +32,14 @@ struct bbparameters {
 	const int U0;
 	const float Uf;
 
-	bbparameters(bool _pb, bool _epb, bool _mb, bool _fb, int _U0, float _Uf)
-		: pb(_pb), epb(_epb), mb(_mb), fb(_fb), U0(_U0), Uf(_Uf) { }
+	// The branching order, and the seed used for randomized orders.
+	const branch_order order;
+	const unsigned seed;
+
+	bbparameters(bool _pb, bool _epb, bool _mb, bool _fb, int _U0, float _Uf,
+		branch_order _order = branch_order::degree, unsigned _seed = 0)
+		: pb(_pb), epb(_epb), mb(_mb), fb(_fb), U0(_U0), Uf(_Uf),
+		order(_order), seed(_seed) { }
 
 	// Returns whether or not the configuration is valid, and if not, a string
 	// describing the problem.
@@ -2,66 +2,71 @@
 
 #include <algorithm>
 #include <cmath>
-#include <ctime>
+#include <functional>
+#include <limits>
 #include <numeric>
+#include <random>
+#include <thread>
 
 #include "../datastructures/matrix-util.h"
+#include "../fm/fm-partitioner.h"
+#include "../io/output.h"
 
 namespace mp {
 
 constexpr long long PERIOD_SMALL = 1000LL;
+constexpr long long PERIOD_SHARE = 64LL;
+
+// Subtrees taking at least this many steps are remembered between rounds.
+constexpr long long MEMO_STEPS = 256LL;
+
+// Number of assignments spent on bounding the root before the first round.
+constexpr long long PROBE_BUDGET = 1000LL;
+
+constexpr int INF = std::numeric_limits<int>::max();
 
 bool bbpartitioner::partition(const matrix &m, std::vector<status> &row,
 		std::vector<status> &col, float epsilon, long long tl) {
 	bool valid;
 	std::string error;
 	std::tie(valid, error) = param.valid();
+	explored = 0;
+	proven = 0;
 	if (!valid) {
+		std::lock_guard<std::mutex> guard(debug_lock());
 		std::cerr << "Invalid parameters: " << error << std::endl;
 		return false;
 	}
 
-	int max_partition_size = static_cast<int>(
-		(1.0f + epsilon) * ((m.NZ + 1) / 2));
-	if (2 * max_partition_size < m.NZ) {
+	if (2 * max_partition_size(m.NZ, epsilon) < m.NZ) {
+		std::lock_guard<std::mutex> guard(debug_lock());
 		std::cerr << "No valid partitioning exists with this value of epsilon."
 			<< std::endl;
 		return false;
 	}
 
-	// Decide in which order to recurse on the rows/columns.
-	std::vector<int> recursion_order(m.R + m.C, 0);
-	std::iota(recursion_order.begin(), recursion_order.end(), 0);
-	std::sort(recursion_order.begin(), recursion_order.end(),
-		[&m](const int &l, const int &r) -> bool {
-			return m[l].size() > m[r].size(); });
-
-	// Partial partition.
-	partial_partition pp(m, param, max_partition_size);
+	// Optimal partition sofar, starting from a trivial bound or a warm start.
+	incumbent best(m.R + m.C, std::min(m.R, m.C) + 2);
+	best.warm_start(start_status, start_lb);
+	start_status.clear();
+	start_lb = 0;
 
-	// Optimal partition sofar.
-	std::vector<status> optimal_status(m.R + m.C, status::unassigned);
-	row.assign(m.R, status::unassigned);
-	col.assign(m.C, status::unassigned);
+	auto start = std::chrono::steady_clock::now();
+	auto deadline = tl > 0 ? start + std::chrono::seconds(tl)
+		: std::chrono::steady_clock::time_point::max();
+	int optimal_value = run(m, epsilon, deadline, best);
+	proven = optimal_value >= 0 ? optimal_value : best.lower_bound();
 
-	// Solve and store optimal status.
-	int optimal_value = 1;
-	double start = (double)clock();
-	for (int U = param.U0, PU = 0;;
-			PU = U, U = int(std::ceil(param.Uf * U))) {
-		std::cerr << "Running with bound " << U << std::endl;
-		optimal_value = solve(recursion_order, pp, optimal_status,
-					tl > 0 ? start + tl * CLOCKS_PER_SEC : 0.0,
-					PU, U);
-		if (optimal_value < U) break;
-	}
-
-	for (int r = 0; r < m.R; ++r) row[r] = optimal_status[r];
-	for (int c = 0; c < m.C; ++c) col[c] = optimal_status[m.R + c];
+	std::vector<status> optimal_status;
+	best.retrieve(optimal_status);
+	row.assign(optimal_status.begin(), optimal_status.begin() + m.R);
+	col.assign(optimal_status.begin() + m.R, optimal_status.end());
+	std::lock_guard<std::mutex> guard(debug_lock());
 	if (optimal_value >= 0) {
 		std::cerr << "Finished, found partition of volume " << optimal_value
 			<< std::endl;
-		std::cerr << "Used ~" << (std::ceil(clock()-start)/CLOCKS_PER_SEC)
+		std::cerr << "Used ~" << std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - start).count()
 			<< " seconds." << std::endl;
 		return true;
 	} else {
@@ -71,17 +76,131 @@ bool bbpartitioner::partition(const matrix &m, std::vector<status> &row,
 	}
 }
 
-void bbpartitioner::recurse(int rc, status stat,
-		std::stack<recursion_step> &call_stack, const partial_partition &pp) {
-	if (!pp.can_assign(rc, stat)) return;
-	call_stack.push(
+void bbpartitioner::warm_start(const std::vector<status> &s, int lb) {
+	start_status = s;
+	start_lb = lb;
+}
+
+int bbpartitioner::run(const matrix &m, float epsilon,
+		std::chrono::steady_clock::time_point deadline, incumbent &best) {
+	// Without nonzeros there is nothing to cut, and nothing to search.
+	if (m.NZ == 0) {
+		explored = 0;
+		best.offer(0, std::vector<status>(m.R + m.C, status::red));
+		best.finish();
+		return 0;
+	}
+
+	// Decide in which order to recurse on the rows/columns.
+	std::vector<int> recursion_order(m.R + m.C, 0);
+	std::iota(recursion_order.begin(), recursion_order.end(), 0);
+	std::mt19937 rng(param.seed);
+	if (param.order != branch_order::degree)
+		std::shuffle(recursion_order.begin(), recursion_order.end(), rng);
+	if (param.order == branch_order::degree) {
+		std::sort(recursion_order.begin(), recursion_order.end(),
+			[&m](const int &l, const int &r) -> bool {
+				return m[l].size() > m[r].size(); });
+	} else if (param.order == branch_order::shuffled_degree) {
+		std::stable_sort(recursion_order.begin(), recursion_order.end(),
+			[&m](const int &l, const int &r) -> bool {
+				return m[l].size() > m[r].size(); });
+	}
+
+	// Workers, each with its own partial partition. Those of an earlier run
+	// are reused.
+	int mps = max_partition_size(m.NZ, epsilon);
+	workers.resize(std::max(1, threads));
+	for (auto &w : workers) {
+		if (w)
+			w->reset(m, mps, recursion_order);
+		else
+			w.reset(new bbworker(m, param, mps, recursion_order));
+	}
+
+	// Start from a heuristic partitioning, so that branches can be pruned
+	// against it from the first round on.
+	std::vector<status> row, col;
+	if (fmpartitioner(param.seed).partition(m, row, col, epsilon, 0)) {
+		row.insert(row.end(), col.begin(), col.end());
+		int volume = (int)std::count(row.begin(), row.end(), status::cut);
+		if (best.offer(volume, row)) {
+			std::lock_guard<std::mutex> guard(debug_lock());
+			std::cerr << "Heuristic solution found with cost " << volume
+				<< std::endl;
+		}
+	}
+
+	// Seed the first upperbound from a lower bound on the root, found by
+	// branching exhaustively on the first few levels.
+	bbworker &w = *workers[0];
+	long long budget = PROBE_BUDGET;
+	for (int depth = 1; depth <= m.R + m.C; ++depth) {
+		w.current_rcs = 0;
+		int root_lb = probe(w, 0, depth, budget);
+		if (root_lb < 0 || root_lb == INF) break;
+		best.prove(root_lb);
+	}
+	{
+		std::lock_guard<std::mutex> guard(debug_lock());
+		std::cerr << "Root lower bound is " << best.lower_bound()
+			<< std::endl;
+	}
+
+	// Solve for increasing upperbounds, until one is met. Every round
+	// proves a lower bound of at least its upperbound, possibly more, and
+	// leaves bounds on expensive subtrees for the next round.
+	bound_table table(m.R + m.C, param.seed);
+	int optimal_value = 1;
+	int PU = best.lower_bound(), U = std::max(param.U0, PU + 1);
+	while (!best.finished()) {
+		{
+			std::lock_guard<std::mutex> guard(debug_lock());
+			std::cerr << "Running with bound " << U << std::endl;
+		}
+		optimal_value = solve(best, table, deadline, PU, U);
+		if (optimal_value < U || best.finished()) break;
+
+		PU = best.lower_bound();
+		U = std::max(int(std::ceil(param.Uf * U)), PU + 1);
+	}
+	if (best.finished())
+		optimal_value = best.value();
+	explored = 0;
+	for (auto &w : workers)
+		explored += w->nodes;
+
+	if (param.fb) {
+		flow_stats stats;
+		for (auto &w : workers) {
+			stats.incremental += w->pp.get_flow_stats().incremental;
+			stats.recomputed += w->pp.get_flow_stats().recomputed;
+		}
+		std::lock_guard<std::mutex> guard(debug_lock());
+		std::cerr << "Flow bound updated " << stats.incremental
+			<< " times incrementally, recomputed " << stats.recomputed
+			<< " times." << std::endl;
+	}
+
+	// Only the buffers are kept for the next run, not the matrix.
+	for (auto &w : workers)
+		w->pp.m = matrix(0, 0);
+
+	if (optimal_value >= 0)
+		best.finish();
+	return optimal_value;
+}
+
+void bbpartitioner::recurse(int rc, status stat, bbworker &w) {
+	if (!w.pp.can_assign(rc, stat)) return;
+	w.call_stack.push_back(
 		recursion_step{
 			recursion_type::ascend,
-			rc, pp.get_status(rc)});
-	call_stack.push(
+			rc, w.pp.get_status(rc), w.current_rcs});
+	w.call_stack.push_back(
 		recursion_step{
 			recursion_type::descend,
-			rc, stat});
+			rc, stat, w.current_rcs});
 }
 
 bool bbpartitioner::pick_next(size_t &current_rcs, std::vector<int> &rcs,
@@ -89,65 +208,84 @@ bool bbpartitioner::pick_next(size_t &current_rcs, std::vector<int> &rcs,
 	if (current_rcs == rcs.size() || lower_bound >= upper_bound)
 		return false;
 
-	// First we branch on implicitly cut vertices, if they exist.
-	for (size_t i = current_rcs; i < rcs.size(); ++i) {
-		if (pp.get_status(rcs[i]) == status::implicitly_cut) {
-			std::swap(rcs[current_rcs], rcs[i]);
-			return true;
-		}
-	}
-
-	// If not, we aggregate some statistics for each vertex and pick the
-	// (subjectively) best option.
-	long long curscore = -1LL;
-	for (size_t i = current_rcs; i < rcs.size(); ++i) {
-		int free = pp.get_free_nonzeros(rcs[i]);
-
-		long long score = 1;
-		score *= (long long)(1 + free);
-		if (score > curscore) {
-			curscore = score;
-			std::swap(rcs[current_rcs], rcs[i]);
-		}
-	}
-
+	// First we branch on implicitly cut vertices, if they exist. If not, on
+	// the vertex with the most free nonzeros.
+	rcs[current_rcs] = pp.next_branch();
 	return true;
 }
 
-int bbpartitioner::make_step(std::stack<recursion_step> &call_stack,
-		size_t &current_rcs, std::vector<int> &rcs, partial_partition &pp,
+int bbpartitioner::make_step(bbworker &w, const bound_table &table,
 		int upper_bound) {
-	recursion_step step = call_stack.top();
-	call_stack.pop();
+	partial_partition &pp = w.pp;
+	std::vector<int> &rcs = w.rcs;
+	size_t &current_rcs = w.current_rcs;
+
+	recursion_step step = w.call_stack.back();
+	w.call_stack.pop_back();
+	++w.steps;
 	
 	int lb = -1;
 	if (step.rt == recursion_type::descend) {
+		// Skip the subtree (and its ascend) if an earlier round proved it
+		// to be too expensive.
+		uint64_t key = w.key ^ table.key(step.rc, step.s);
+		int known = table.get(key);
+		if (known >= upper_bound) {
+			w.call_stack.pop_back();
+			w.frontier = std::min(w.frontier, known);
+			w.subtree_lb[current_rcs] = std::min(
+				w.subtree_lb[current_rcs], known);
+			return lb;
+		}
+
+		w.key = key;
 		lb = pp.assign(step.rc, step.s, upper_bound);
+		++w.nodes;
 
 		// Try branching again.
 		++current_rcs;
+		w.subtree_lb[current_rcs] = INF;
+		w.entered[current_rcs] = w.steps;
 		if (pick_next(current_rcs, rcs, pp, lb, upper_bound)) {
 			// Recurse on the cut last (note that branches are executed on a
 			// stack and thus in reverse order). Also, if lb + 1 == ub and this
 			// vertex is NOT implicitly cut, there is no need to branch on
 			// the cut.
 			if (pp.get_status(rcs[current_rcs]) == mp::status::implicitly_cut
-					|| pp.get_guaranteed_lower_bound() + 1 < upper_bound)
-				recurse(rcs[current_rcs], status::cut, call_stack, pp);
+					|| pp.get_guaranteed_lower_bound() + 1 < upper_bound) {
+				recurse(rcs[current_rcs], status::cut, w);
+			} else {
+				int cut_lb = pp.get_guaranteed_lower_bound() + 1;
+				w.frontier = std::min(w.frontier, cut_lb);
+				w.subtree_lb[current_rcs] = cut_lb;
+			}
 
 			// First branch on the smaller component.
 			if (pp.get_partition_size(0) > pp.get_partition_size(1)) {
-				recurse(rcs[current_rcs], status::red, call_stack, pp);
-				recurse(rcs[current_rcs], status::blue, call_stack, pp);
+				recurse(rcs[current_rcs], status::red, w);
+				recurse(rcs[current_rcs], status::blue, w);
 			} else {
 				if (pp.get_partition_size(0) > 0)
-					recurse(rcs[current_rcs], status::blue, call_stack, pp);
-				recurse(rcs[current_rcs], status::red, call_stack, pp);
+					recurse(rcs[current_rcs], status::blue, w);
+				recurse(rcs[current_rcs], status::red, w);
 				// Note that we only recurse into 'blue' if a red row/column
 				// already exists, this is to break symmetry.
 			}
+		} else {
+			// A leaf, or cut off by the bound.
+			w.frontier = std::min(w.frontier, lb);
+			w.subtree_lb[current_rcs] = lb;
 		}
 	} else { // step.rt == recursion_type::ascend
+		// The subtree is exhausted. Remember its bound if it was expensive
+		// to establish.
+		int subtree_lb = w.subtree_lb[current_rcs];
+		if (subtree_lb > 0 && w.steps - w.entered[current_rcs] >= MEMO_STEPS)
+			w.found.emplace_back(w.key, subtree_lb);
+		w.subtree_lb[current_rcs - 1] = std::min(
+			w.subtree_lb[current_rcs - 1], subtree_lb);
+
+		w.key ^= table.key(step.rc, pp.get_status(step.rc));
 		pp.undo(step.rc, step.s);
 		--current_rcs;
 	}
@@ -155,54 +293,247 @@ int bbpartitioner::make_step(std::stack<recursion_step> &call_stack,
 	return lb;
 }
 
-int bbpartitioner::solve(std::vector<int> &rcs, partial_partition &pp,
-		std::vector<status> &optimal_status, double limit,
-		int slb, int sub) {
-	// `rcs` describes the order in which we pass through the rows/columns,
-	// rcs[current_rcs] is the next row/column to branch on.
-	size_t current_rcs = 0;
+int bbpartitioner::probe(bbworker &w, int lb, int depth, long long &budget) {
+	partial_partition &pp = w.pp;
+	if (depth == 0 || !pick_next(w.current_rcs, w.rcs, pp, lb, INF))
+		return lb;
 
-	// The current call stack. We manually only add `red` and `cut` (no `blue`,
-	// this is to break symmetry.
-	std::stack<recursion_step> call_stack;
-	recurse(rcs[0], status::cut, call_stack, pp);
-	recurse(rcs[0], status::red, call_stack, pp);
+	int rc = w.rcs[w.current_rcs], result = INF;
+	for (status s : {status::red, status::blue, status::cut}) {
+		// Break symmetry as in make_step.
+		if (s == status::blue && pp.get_partition_size(RED) == 0) continue;
+		if (!pp.can_assign(rc, s)) continue;
+		if (--budget < 0) return -1;
 
-	// Pick a good starting bound.
-	int optimal_value = std::min(pp.m.R, pp.m.C) + 2;
-	if (sub > 0 && sub < optimal_value)
-		optimal_value = sub;
+		status os = pp.get_status(rc);
+		int clb = pp.assign(rc, s, INF);
+		++w.current_rcs;
+		int value = probe(w, clb, depth - 1, budget);
+		--w.current_rcs;
+		pp.undo(rc, os);
+
+		if (value < 0) return -1;
+		result = std::min(result, value);
+	}
+	return result;
+}
+
+int bbpartitioner::solve(incumbent &best, bound_table &table,
+		std::chrono::steady_clock::time_point deadline, int slb, int sub) {
+	search_control sc(workers, best, table, deadline, sub > 0 ? sub : INF);
+
+	// If we are already hitting the suggested lower bound we can stop.
+	best.prove(slb);
+	if (best.finished())
+		return best.value();
+
+	for (auto &w : workers) w->frontier = INF;
+
+	// Seed the first worker with the root of the B&B tree. We manually only
+	// add `red` and `cut` (no `blue`), this is to break symmetry. Subtrees
+	// are taken from the back, so `red` is explored first.
+	sc.pending = 2;
+	int root = workers[0]->pp.next_branch();
+	for (status s : {status::cut, status::red}) {
+		workers[0]->open.push_back(subtree{{},
+			recursion_step{recursion_type::descend, root, s, 0}});
+	}
+
+	// The calling thread acts as the first worker.
+	std::vector<std::thread> pool;
+	for (size_t i = 1; i < workers.size(); ++i) {
+		pool.emplace_back(&bbpartitioner::search, this,
+			std::ref(*workers[i]), std::ref(sc));
+	}
+	search(*workers[0], sc);
+	for (std::thread &t : pool) t.join();
+
+	// Drop whatever was left when stopping early, and keep the subtree
+	// bounds for the next round.
+	int frontier = INF;
+	for (auto &w : workers) {
+		w->open.clear();
+		for (const auto &f : w->found)
+			if (!table.record(f.first, f.second)) break;
+		w->found.clear();
+		frontier = std::min(frontier, w->frontier);
+	}
+
+	// The incumbent may have been proven optimal elsewhere.
+	if (best.finished())
+		return best.value();
+
+	// An exhausted search proves there is nothing below the bound, nor
+	// below any bound at which it cut off branches.
+	int optimal_value = std::min(sc.sub, best.value());
+	if (sc.timeout)
+		return -optimal_value;
+	best.prove(std::max(optimal_value, std::min(frontier, best.value())));
+	return optimal_value;
+}
+
+void bbpartitioner::search(bbworker &w, search_control &sc) {
+	bool idle = false;
+	subtree t;
+	while (!sc.stop) {
+		if (take(w, sc, t)) {
+			if (idle) {
+				idle = false;
+				--sc.idle;
+			}
+			explore(w, t, sc);
+			--sc.pending;
+		} else {
+			// Every subtree has been explored.
+			if (sc.pending == 0) break;
+
+			// Otherwise, signal the other workers to share.
+			if (!idle) {
+				idle = true;
+				++sc.idle;
+			}
+			std::this_thread::yield();
+		}
+	}
+	if (idle) --sc.idle;
+}
+
+bool bbpartitioner::take(bbworker &w, search_control &sc, subtree &t) {
+	{
+		std::lock_guard<std::mutex> guard(w.open_lock);
+		if (!w.open.empty()) {
+			t = std::move(w.open.back());
+			w.open.pop_back();
+			return true;
+		}
+	}
+
+	// Steal the oldest (and presumably largest) subtree of another worker.
+	for (auto &v : sc.workers) {
+		if (v.get() == &w) continue;
+		std::lock_guard<std::mutex> guard(v->open_lock);
+		if (!v->open.empty()) {
+			t = std::move(v->open.front());
+			v->open.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+void bbpartitioner::share(bbworker &w, search_control &sc) {
+	std::lock_guard<std::mutex> guard(w.open_lock);
+	if (!w.open.empty()) return;
+
+	// The bottom-most descend step spans the largest open subtree. Since the
+	// rows/columns in rcs[0, depth) stay assigned for as long as the step is
+	// on the stack, they describe its prefix.
+	for (size_t i = 0; i < w.call_stack.size(); ++i) {
+		const recursion_step &step = w.call_stack[i];
+		if (step.rt != recursion_type::descend) continue;
+
+		subtree t;
+		t.prefix.reserve(step.depth);
+		for (size_t d = 0; d < step.depth; ++d)
+			t.prefix.emplace_back(w.rcs[d], w.pp.get_status(w.rcs[d]));
+		t.step = step;
+
+		// The bounds of its ancestors no longer cover their whole subtrees.
+		for (size_t d = 0; d <= step.depth; ++d)
+			w.subtree_lb[d] = 0;
+
+		// Remove the step together with its ascend, which recurse pushed
+		// directly below it.
+		w.call_stack.erase(w.call_stack.begin() + (i - 1),
+			w.call_stack.begin() + (i + 1));
+		++sc.pending;
+		w.open.push_back(std::move(t));
+		return;
+	}
+}
+
+void bbpartitioner::explore(bbworker &w, const subtree &t,
+		search_control &sc) {
+	partial_partition &pp = w.pp;
+
+	// The prefix and the row/column of the step make up the path so far.
+	for (size_t d = 0; d < t.prefix.size(); ++d)
+		w.rcs[d] = t.prefix[d].first;
+	w.rcs[t.prefix.size()] = t.step.rc;
+
+	// Replay the prefix. The incumbent may have improved since the subtree
+	// was opened, in which case it can be pruned right away.
+	int lb = 0, ub = std::min(sc.sub, sc.best.value());
+	w.prefix_stat.clear();
+	w.key = 0;
+	for (const auto &a : t.prefix) {
+		w.prefix_stat.push_back(pp.get_status(a.first));
+		w.key ^= sc.table.key(a.first, a.second);
+		lb = pp.assign(a.first, a.second, ub);
+		if (lb >= ub) break;
+	}
+
+	if (lb < ub) {
+		// Only the subtree below the step is explored here.
+		w.current_rcs = t.prefix.size();
+		for (size_t d = 0; d <= w.current_rcs; ++d)
+			w.subtree_lb[d] = 0;
+		recurse(t.step.rc, t.step.s, w);
+	} else {
+		w.frontier = std::min(w.frontier, lb);
+	}
 
 	// Now we manually apply recursion steps until the call stack is empty,
 	// effectively traversing the B&B tree.
 	long long progress_counter = 0;
-	while (!call_stack.empty()) {
-		int lb = make_step(call_stack, current_rcs, rcs, pp, optimal_value);
-		if (current_rcs == rcs.size()) {
-			if (optimal_value > lb) {
-				optimal_value = lb;
-				for (size_t i = 0; i < optimal_status.size(); ++i)
-					optimal_status[i] = pp.get_status(i);
+	while (!w.call_stack.empty() && !sc.stop.load(std::memory_order_relaxed)) {
+		ub = std::min(sc.sub, sc.best.value());
+		lb = make_step(w, sc.table, ub);
+		if (w.current_rcs == w.rcs.size() && lb < ub) {
+			if (sc.best.offer(lb, pp)) {
+				std::lock_guard<std::mutex> guard(debug_lock());
 				std::cerr << "Improved solution found with cost " << lb
 					<< std::endl;
-				// If we are already hitting the suggested lower bound we
-				// can stop.
-				if (slb >= optimal_value) {
-					return optimal_value;
-				}
 			}
+			// If we are already hitting the suggested lower bound we can
+			// stop.
+			if (sc.best.finished())
+				sc.stop = true;
 		}
 
 		progress_counter++;
+		if (progress_counter % PERIOD_SHARE == 0LL) {
+			if (sc.idle.load(std::memory_order_relaxed) > 0)
+				share(w, sc);
+			if (sc.best.finished())
+				sc.stop = true;
+		}
 		if (progress_counter % PERIOD_SMALL == 0LL) {
-			if (limit > 0 && clock() > limit) {
-				// Out of time.
-				return -optimal_value;
+			if (std::chrono::steady_clock::now() > sc.deadline
+					|| sc.best.cancelled()) {
+				// Out of time, or cancelled.
+				sc.timeout = true;
+				sc.stop = true;
 			}
 		}
 	}
 
-	return optimal_value;
+	// When stopped early, unwind what is left of the call stack. Pending
+	// descend steps are dropped together with their ascend.
+	while (!w.call_stack.empty()) {
+		recursion_step step = w.call_stack.back();
+		w.call_stack.pop_back();
+		if (step.rt == recursion_type::descend) {
+			w.call_stack.pop_back();
+		} else {
+			pp.undo(step.rc, step.s);
+			--w.current_rcs;
+		}
+	}
+
+	// Undo the prefix.
+	for (size_t i = w.prefix_stat.size(); i-- > 0; )
+		pp.undo(t.prefix[i].first, w.prefix_stat[i]);
 }
 
 }
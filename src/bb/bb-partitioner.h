@@ -1,10 +1,18 @@
 #ifndef BBPARTITIONER_H
 #define BBPARTITIONER_H
 
-#include <stack>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 #include "./bb-parameters.h"
+#include "./bound-table.h"
 #include "../datastructures/matrix.h"
+#include "./incumbent.h"
 #include "./partial-partition.h"
 #include "../partitioner/partitioner.h"
 #include "../partitioner/partition-util.h"
@@ -17,6 +25,104 @@ struct recursion_step {
 	recursion_type rt;
 	int rc;
 	status s;
+	// Depth of the B&B node this step was generated from.
+	size_t depth;
+};
+
+// An open subtree of the B&B tree, described by the assignments leading up
+// to it (in order) and the step into it. Used to hand work to other workers.
+struct subtree {
+	std::vector<std::pair<int, status>> prefix;
+	recursion_step step;
+};
+
+// A single search thread. Every worker owns a replica of the partial
+// partition and its own call stack, and exposes open subtrees for idle
+// workers to steal.
+struct bbworker {
+	partial_partition pp;
+
+	// rcs[0, current_rcs) are the rows/columns branched on along the current
+	// path, rcs[current_rcs] is the next row/column to branch on.
+	std::vector<int> rcs;
+	size_t current_rcs = 0;
+
+	// The current call stack (top at the back). Exported subtrees are cut
+	// from the bottom.
+	std::deque<recursion_step> call_stack;
+
+	// Subtrees exported by this worker, guarded by open_lock.
+	std::deque<subtree> open;
+	std::mutex open_lock;
+
+	// Old statuses of the replayed prefix, to undo it afterwards.
+	std::vector<status> prefix_stat;
+
+	// Hash of the current partial assignment (see bound_table).
+	uint64_t key = 0;
+
+	// For each node on the current path: the least lower bound found in its
+	// subtree sofar, and the step count when it was entered. A bound of 0
+	// means part of the subtree was explored elsewhere.
+	std::vector<int> subtree_lb;
+	std::vector<long long> entered;
+	long long steps = 0;
+
+	// Number of B&B nodes entered.
+	long long nodes = 0;
+
+	// The least lower bound at which any branch was cut off this round, and
+	// the subtree bounds found worth remembering.
+	int frontier = 0;
+	std::vector<std::pair<uint64_t, int>> found;
+
+	bbworker(const matrix &m, bbparameters param, int max_partition_size,
+		const std::vector<int> &order)
+		: pp(m, param, max_partition_size), rcs(m.R + m.C, -1),
+		subtree_lb(m.R + m.C + 1, 0), entered(m.R + m.C + 1, 0) {
+		pp.set_branch_order(order);
+	}
+
+	// Start over on another matrix, reusing the buffers of the previous one.
+	void reset(const matrix &m, int max_partition_size,
+			const std::vector<int> &order) {
+		pp.reset(m, max_partition_size);
+		pp.set_branch_order(order);
+		rcs.assign(m.R + m.C, -1);
+		current_rcs = 0;
+		call_stack.clear();
+		open.clear();
+		prefix_stat.clear();
+		key = 0;
+		subtree_lb.assign(m.R + m.C + 1, 0);
+		entered.assign(m.R + m.C + 1, 0);
+		steps = nodes = 0;
+		frontier = 0;
+		found.clear();
+	}
+};
+
+// Coordination between the workers during a single call to solve.
+struct search_control {
+	std::vector<std::unique_ptr<bbworker>> &workers;
+	incumbent &best;
+	const bound_table &table;
+	std::chrono::steady_clock::time_point deadline;
+
+	// The solution is sought below sub.
+	int sub;
+
+	// Number of workers without work, and number of subtrees that are
+	// either waiting to be stolen or being explored.
+	std::atomic<int> idle, pending;
+	std::atomic<bool> stop, timeout;
+
+	search_control(std::vector<std::unique_ptr<bbworker>> &_workers,
+		incumbent &_best, const bound_table &_table,
+		std::chrono::steady_clock::time_point _deadline, int _sub)
+		: workers(_workers), best(_best), table(_table),
+		deadline(_deadline), sub(_sub), idle(0), pending(0),
+		stop(false), timeout(false) { }
 };
 
 // Branch and bound partitioner.
@@ -24,30 +130,80 @@ class bbpartitioner : public partitioner {
   private:
 	bbparameters param;
 
+	// Number of worker threads used to explore the B&B tree.
+	int threads;
+
+	// Number of B&B nodes explored and lower bound proven by the last run.
+	long long explored = 0;
+	int proven = 0;
+
+	// Known partitioning and lower bound to start the next run from.
+	std::vector<status> start_status;
+	int start_lb = 0;
+
+	// The workers of the last run, each with its own partial partition.
+	// They are reset for the next run, so that a long-lived partitioner does
+	// not allocate the search state of every matrix anew.
+	std::vector<std::unique_ptr<bbworker>> workers;
+
 	// slb and sub are suggested lower and upperbounds. The solution will be
-	// sought in [slb, sub). Returns -best-so-far when out of time. Limit
-	// should be compared to clock() (i.e. set to clock()+t*CLOCKS_PER_SEC).
-	int solve(std::vector<int> &rcs, partial_partition &pp,
-		std::vector<status> &optimal_status, double limit,
-		int slb = 0, int sub = -1);
+	// sought in [slb, sub), improving solutions are offered to best. Returns
+	// -best-so-far when the (wall clock) deadline passes. The search stops
+	// early once best is proven optimal, possibly by another search.
+	// Subtrees are skipped if table proves them too expensive, and bounds on
+	// expensive subtrees are recorded in it afterwards. An exhausted search
+	// proves the least bound at which it cut off a branch to best.
+	int solve(incumbent &best, bound_table &table,
+		std::chrono::steady_clock::time_point deadline, int slb = 0,
+		int sub = -1);
 
-	// Returns the lower bound after a descend, -1 for an ascend.
-	int make_step(std::stack<recursion_step> &call_stack, size_t &current_rcs,
-		std::vector<int> &rcs, partial_partition &pp, int upper_bound);
+	// Lower bound on the subtree below the current node of w (with lower
+	// bound lb), found by exhaustively branching depth more levels. Returns
+	// -1 if the budget of assignments runs out first.
+	int probe(bbworker &w, int lb, int depth, long long &budget);
 
-	void recurse(int rc, status stat, std::stack<recursion_step> &call_stack,
-		const partial_partition &pp);
+	// Main loop of a worker: explore own and stolen subtrees until the
+	// whole tree has been explored.
+	void search(bbworker &w, search_control &sc);
 
-	// Pick the next vertex to branch on. Just moves it into position
+	// Take an open subtree, preferably from w itself.
+	bool take(bbworker &w, search_control &sc, subtree &t);
+
+	// Export the largest open subtree of w, if w has none exported yet.
+	void share(bbworker &w, search_control &sc);
+
+	// Replay the prefix of t on w and explore the subtree below it.
+	void explore(bbworker &w, const subtree &t, search_control &sc);
+
+	// Returns the lower bound after a descend, -1 for an ascend or a skipped
+	// descend.
+	int make_step(bbworker &w, const bound_table &table, int upper_bound);
+
+	void recurse(int rc, status stat, bbworker &w);
+
+	// Pick the next vertex to branch on. Just puts it into position
 	// rcs[current_rcs] so the algorithm will pick it up.
 	bool pick_next(size_t &current_rcs, std::vector<int> &rcs,
 		partial_partition &pp, int lower_bound, int upper_bound);
 
   public:
-	bbpartitioner(bbparameters _param) : param(_param) { }
+	bbpartitioner(bbparameters _param, int _threads = 1)
+		: param(_param), threads(_threads) { }
 
 	virtual bool partition(const matrix &m, std::vector<status> &row,
 		std::vector<status> &col, float epsilon, long long tl);
+
+	virtual long long nodes() const { return explored; }
+	virtual int lower_bound() const { return proven; }
+	virtual void warm_start(const std::vector<status> &s, int lb);
+
+	// Search for an optimal partitioning of m, sharing the incumbent with
+	// any other searches using it. Returns the optimal volume, or minus the
+	// last upperbound when the deadline passes (or the incumbent is
+	// cancelled) first. The parameters are
+	// assumed to be valid. Runs may not overlap.
+	int run(const matrix &m, float epsilon,
+		std::chrono::steady_clock::time_point deadline, incumbent &best);
 };
 
 }
@@ -0,0 +1,125 @@
+#include "./bb-portfolio.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+#include "./bb-partitioner.h"
+#include "./incumbent.h"
+#include "../io/output.h"
+
+namespace mp {
+
+std::vector<bbparameters> bbportfolio::default_configurations(int n) {
+	const std::vector<bbparameters> base = {
+		// pb, epb, mb, fb, U0, Uf, order, seed
+		{true, true, false, true, 1, 1.25f},
+		{true, false, false, true, 1, 1.25f},
+		{true, false, false, false, 1, 1.25f},
+		{true, true, false, true, 1, 1.5f, branch_order::shuffled_degree, 1},
+		{true, true, false, true, 2, 1.1f, branch_order::shuffled_degree, 2},
+		{false, false, false, true, 1, 1.25f},
+		{true, true, false, true, 1, 2.0f, branch_order::random, 3},
+		{true, false, false, true, 1, 1.25f, branch_order::shuffled_degree, 4}
+	};
+
+	// Beyond the base configurations we only vary the seed.
+	std::vector<bbparameters> configurations;
+	for (int i = 0; i < n; ++i) {
+		if (i < (int)base.size()) {
+			configurations.push_back(base[i]);
+		} else {
+			configurations.push_back(bbparameters(true, true, false, true,
+				1, 1.25f, branch_order::shuffled_degree, (unsigned)i));
+		}
+	}
+	return configurations;
+}
+
+void bbportfolio::warm_start(const std::vector<status> &s, int lb) {
+	start_status = s;
+	start_lb = lb;
+}
+
+bool bbportfolio::partition(const matrix &m, std::vector<status> &row,
+		std::vector<status> &col, float epsilon, long long tl) {
+	// Only race the valid configurations.
+	explored = 0;
+	proven = 0;
+	std::vector<bbparameters> valid_configurations;
+	for (const bbparameters &param : configurations) {
+		bool valid;
+		std::string error;
+		std::tie(valid, error) = param.valid();
+		if (valid) {
+			valid_configurations.push_back(param);
+		} else {
+			std::lock_guard<std::mutex> guard(debug_lock());
+			std::cerr << "Skipping invalid parameters: " << error << std::endl;
+		}
+	}
+	if (valid_configurations.empty()) {
+		std::lock_guard<std::mutex> guard(debug_lock());
+		std::cerr << "No valid parameters in portfolio." << std::endl;
+		return false;
+	}
+
+	if (2 * max_partition_size(m.NZ, epsilon) < m.NZ) {
+		std::lock_guard<std::mutex> guard(debug_lock());
+		std::cerr << "No valid partitioning exists with this value of epsilon."
+			<< std::endl;
+		return false;
+	}
+
+	// Shared partition sofar, starting from a trivial bound or a warm start.
+	incumbent best(m.R + m.C, std::min(m.R, m.C) + 2);
+	best.warm_start(start_status, start_lb);
+	start_status.clear();
+	start_lb = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	auto deadline = tl > 0 ? start + std::chrono::seconds(tl)
+		: std::chrono::steady_clock::time_point::max();
+
+	// Start the race. The matrix is shared, read-only.
+	std::vector<int> result(valid_configurations.size(), -1);
+	std::vector<long long> nodes(valid_configurations.size(), 0);
+	std::vector<std::thread> pool;
+	for (size_t i = 0; i < valid_configurations.size(); ++i) {
+		pool.emplace_back([&, i]() {
+			bbpartitioner bb(valid_configurations[i], threads);
+			result[i] = bb.run(m, epsilon, deadline, best);
+			nodes[i] = bb.nodes();
+
+			std::lock_guard<std::mutex> guard(debug_lock());
+			std::cerr << "Configuration " << i << " stopped with "
+				<< (result[i] >= 0 ? "optimal value " : "upperbound ")
+				<< std::abs(result[i]) << std::endl;
+		});
+	}
+	for (std::thread &t : pool) t.join();
+	for (long long n : nodes) explored += n;
+	proven = best.finished() ? best.value() : best.lower_bound();
+
+	std::vector<status> optimal_status;
+	best.retrieve(optimal_status);
+	row.assign(optimal_status.begin(), optimal_status.begin() + m.R);
+	col.assign(optimal_status.begin() + m.R, optimal_status.end());
+	std::lock_guard<std::mutex> guard(debug_lock());
+	if (best.finished()) {
+		std::cerr << "Finished, found partition of volume " << best.value()
+			<< std::endl;
+		std::cerr << "Used ~" << std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - start).count()
+			<< " seconds." << std::endl;
+		return true;
+	} else {
+		std::cerr << "Out of time, last upperbound was " << best.value()
+			<< std::endl;
+		return false;
+	}
+}
+
+}
@@ -0,0 +1,51 @@
+#ifndef BBPORTFOLIO_H
+#define BBPORTFOLIO_H
+
+#include <vector>
+
+#include "./bb-parameters.h"
+#include "../datastructures/matrix.h"
+#include "../partitioner/partitioner.h"
+#include "../partitioner/partition-util.h"
+
+namespace mp {
+
+// Races several branch and bound configurations against each other, each in
+// its own thread(s) on the same matrix. The runs share their incumbent and
+// proven lower bounds, and all stop as soon as optimality is proven.
+class bbportfolio : public partitioner {
+  private:
+	std::vector<bbparameters> configurations;
+
+	// Number of worker threads for each configuration.
+	int threads;
+
+	// Number of B&B nodes explored by all configurations in the last race,
+	// and the lower bound proven.
+	long long explored = 0;
+	int proven = 0;
+
+	// Known partitioning and lower bound to start the next race from.
+	std::vector<status> start_status;
+	int start_lb = 0;
+
+  public:
+	bbportfolio(const std::vector<bbparameters> &_configurations,
+		int _threads = 1)
+		: configurations(_configurations), threads(_threads) { }
+
+	// A portfolio of n configurations, varying the bounds used, the initial
+	// upperbound and scaling factor, and the branching order and seed.
+	static std::vector<bbparameters> default_configurations(int n);
+
+	virtual bool partition(const matrix &m, std::vector<status> &row,
+		std::vector<status> &col, float epsilon, long long tl);
+
+	virtual long long nodes() const { return explored; }
+	virtual int lower_bound() const { return proven; }
+	virtual void warm_start(const std::vector<status> &s, int lb);
+};
+
+}
+
+#endif
@@ -0,0 +1,42 @@
+#include "./bound-table.h"
+
+#include <algorithm>
+#include <random>
+
+namespace mp {
+
+// Maximal number of subtrees remembered.
+constexpr size_t TABLE_CAPACITY = 1 << 20;
+
+bound_table::bound_table(int n, unsigned seed) : keys(3 * n) {
+	std::mt19937_64 rng(seed);
+	for (uint64_t &k : keys) k = rng();
+}
+
+uint64_t bound_table::key(int rc, status s) const {
+	return keys[3 * rc + (int)s];
+}
+
+int bound_table::get(uint64_t hash) const {
+	if (bounds.empty()) return 0;
+	auto it = bounds.find(hash);
+	return it == bounds.end() ? 0 : it->second;
+}
+
+bool bound_table::record(uint64_t hash, int lb) {
+	auto it = bounds.find(hash);
+	if (it != bounds.end()) {
+		it->second = std::max(it->second, lb);
+		return true;
+	}
+	if (bounds.size() >= TABLE_CAPACITY)
+		return false;
+	bounds.emplace(hash, lb);
+	return true;
+}
+
+size_t bound_table::size() const {
+	return bounds.size();
+}
+
+}
@@ -0,0 +1,41 @@
+#ifndef BOUND_TABLE_H
+#define BOUND_TABLE_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "../partitioner/partition-util.h"
+
+namespace mp {
+
+// Lower bounds proven for subtrees of the B&B tree, carried between the
+// rounds of increasing upperbounds. A subtree is identified by a Zobrist hash
+// of its partial assignment (the XOR of the keys of all assignments), so it
+// is recognized regardless of the order in which it was reached.
+class bound_table {
+  public:
+	// A table for n rows/columns. The seed determines the Zobrist keys.
+	bound_table(int n, unsigned seed);
+
+	// Key of assigning status s (red, blue or cut) to rc.
+	uint64_t key(int rc, status s) const;
+
+	// Proven lower bound on the subtree with the given hash, 0 if unknown.
+	// Safe to call concurrently, as long as nobody records.
+	int get(uint64_t hash) const;
+
+	// Record a proven lower bound on the subtree with the given hash. Returns
+	// false if the table is full.
+	bool record(uint64_t hash, int lb);
+
+	size_t size() const;
+
+  private:
+	std::vector<uint64_t> keys;
+	std::unordered_map<uint64_t, int> bounds;
+};
+
+}
+
+#endif
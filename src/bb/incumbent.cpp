@@ -0,0 +1,79 @@
+#include "./incumbent.h"
+
+#include <algorithm>
+
+namespace mp {
+
+incumbent::incumbent(int size, int value) : volume(value), bound(0),
+		optimal(false), stopped(false), stat(size, status::unassigned) { }
+
+int incumbent::value() const {
+	return volume.load(std::memory_order_relaxed);
+}
+
+bool incumbent::offer(int value, const partial_partition &pp) {
+	std::lock_guard<std::mutex> guard(lock);
+	if (value >= volume.load(std::memory_order_relaxed))
+		return false;
+
+	for (size_t i = 0; i < stat.size(); ++i)
+		stat[i] = pp.get_status((int)i);
+	volume.store(value);
+	if (value <= bound.load())
+		finish();
+	return true;
+}
+
+bool incumbent::offer(int value, const std::vector<status> &s) {
+	std::lock_guard<std::mutex> guard(lock);
+	if (value >= volume.load(std::memory_order_relaxed))
+		return false;
+
+	stat = s;
+	volume.store(value);
+	if (value <= bound.load())
+		finish();
+	return true;
+}
+
+void incumbent::retrieve(std::vector<status> &s) const {
+	std::lock_guard<std::mutex> guard(lock);
+	s = stat;
+}
+
+void incumbent::prove(int lb) {
+	int cur = bound.load();
+	while (cur < lb && !bound.compare_exchange_weak(cur, lb)) { }
+	if (volume.load() <= lb)
+		finish();
+}
+
+int incumbent::lower_bound() const {
+	return bound.load(std::memory_order_relaxed);
+}
+
+void incumbent::warm_start(const std::vector<status> &s, int lb) {
+	if (!s.empty() && s.size() == stat.size()) {
+		int value = (int)std::count(s.begin(), s.end(), status::cut);
+		offer(value, s);
+	}
+	prove(lb);
+}
+
+void incumbent::finish() {
+	optimal.store(true);
+}
+
+bool incumbent::finished() const {
+	return optimal.load();
+}
+
+void incumbent::cancel() {
+	stopped.store(true);
+}
+
+bool incumbent::cancelled() const {
+	return stopped.load(std::memory_order_relaxed);
+}
+
+}
@@ -0,0 +1,66 @@
+#ifndef INCUMBENT_H
+#define INCUMBENT_H
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "./partial-partition.h"
+#include "../partitioner/partition-util.h"
+
+namespace mp {
+
+// The best partitioning found so far. It is shared between concurrently
+// running searches, which all prune against its value and report the lower
+// bounds they prove. Once the incumbent meets a proven lower bound it is
+// marked final, after which all searches may stop.
+class incumbent {
+  public:
+	// An incumbent over `size` rows/columns, initially without partitioning
+	// but with the given (trivial) upper bound.
+	incumbent(int size, int value);
+
+	// The volume of the incumbent.
+	int value() const;
+
+	// Replace the incumbent by the current (complete) assignment of pp if
+	// value improves on it. Returns whether the incumbent was replaced.
+	bool offer(int value, const partial_partition &pp);
+
+	// As above, for a partitioning given by the status of every row/column
+	// (rows first), e.g. found by a heuristic.
+	bool offer(int value, const std::vector<status> &s);
+
+	// Copy the statuses of the incumbent.
+	void retrieve(std::vector<status> &s) const;
+
+	// Record that no partitioning of volume less than lb exists, and
+	// retrieve the best such bound proven so far.
+	void prove(int lb);
+	int lower_bound() const;
+
+	// Offer a partitioning found earlier (ignored if s is empty or of the
+	// wrong size), and record a lower bound proven earlier.
+	void warm_start(const std::vector<status> &s, int lb);
+
+	// Mark the incumbent as proven optimal, or check whether it is.
+	void finish();
+	bool finished() const;
+
+	// Stop all searches using the incumbent as if their deadline passed, or
+	// check whether this happened.
+	void cancel();
+	bool cancelled() const;
+
+  private:
+	std::atomic<int> volume, bound;
+	std::atomic<bool> optimal, stopped;
+
+	// Guards stat.
+	mutable std::mutex lock;
+	std::vector<status> stat;
+};
+
+}
+
+#endif
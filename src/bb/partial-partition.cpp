@@ -1,11 +1,10 @@
 #include "./partial-partition.h"
 
 #include <algorithm>
+#include <functional>
 #include <numeric>
-#include <queue>
 
 #include "../datastructures/matrix-util.h"
-#include "../datastructures/min-heap.h"
 #include "../io/output.h"
 #include "../partitioner/partition-util.h"
 
@@ -14,15 +13,64 @@ namespace mp {
 partial_partition::partial_partition(const matrix &_m, bbparameters _param,
 		int _max_partition_size) :
 			param(_param),
-			max_partition_size(_max_partition_size),
-			stat(_m.R + _m.C, status::unassigned),
-			vcg(_param.fb ? _m : matrix(_m.R, _m.C)),
-			dfs_stack(_m.R + _m.C),
-			dfs_index(_m.R + _m.C, -1),
-			dfs_tree_size(_m.R + _m.C, 0),
+			vcg(matrix(0, 0)),
+			dfs_index(0, -1),
 			m(_m) {
+	reset(_m, _max_partition_size);
+}
+
+void partial_partition::reset(const matrix &_m, int _max_partition_size) {
+	m = _m;
+	max_partition_size = _max_partition_size;
+	cut = implicitly_cut = 0;
+	partition_size[RED] = partition_size[BLUE] = 0;
+	lower_bound_cache = -1;
+
+	stat.assign(m.R + m.C, status::unassigned);
 	color_count[RED].assign(m.R + m.C, 0);
 	color_count[BLUE].assign(m.R + m.C, 0);
+	vcg.reset(param.fb ? m : matrix(m.R, m.C));
+	dfs_top.assign(m.R + m.C, -1);
+	dfs_below.assign(m.R + m.C, -1);
+	tree_next.assign(m.R + m.C, -1);
+	dfs_index.assign(m.R + m.C);
+	trail.clear();
+	trail.reserve(m.NZ);
+	trail_frames.clear();
+	trail_frames.reserve(m.R + m.C);
+	flow_frames.clear();
+	flow_frames.reserve(m.R + m.C);
+	flow_batch.clear();
+	flow_batch.reserve(m.R + m.C);
+	epb_changed.clear();
+	for (int c : {RED, BLUE}) {
+		partition_front[c].assign(m.R + m.C);
+		front_version[c] = 0;
+		epb_seen[c].assign(m.R + m.C, 0);
+		epb_frames[c].clear();
+		epb_frames[c].reserve(m.R + m.C);
+		epb_sizes[c].clear();
+		epb_last[c] = 0;
+	}
+	if (param.pb) {
+		for (int roc : {ROWS, COLS})
+			for (int c : {RED, BLUE})
+				simple_packing_set[roc][c].assign(m.Cmax);
+	}
+
+	size_t max_degree = 0;
+	for (int rc = 0; rc < m.R + m.C; ++rc)
+		max_degree = std::max(max_degree, m[rc].size());
+	bucket_head.assign(max_degree + 1, -1);
+	bucket_next.assign(m.R + m.C, -1);
+	bucket_prev.assign(m.R + m.C, -1);
+	implicit.clear();
+	implicit_pos.assign(m.R + m.C, -1);
+
+	// Branch in order of the rows/columns (see set_branch_order).
+	bucket_top = -1;
+	for (int rc = m.R + m.C; rc-- > 0; )
+		enqueue(rc);
 }
 
 bool partial_partition::can_assign(int rc, status s) const {
@@ -53,6 +101,7 @@ bool partial_partition::can_assign(int rc, status s) const {
 
 int partial_partition::assign(int rc, status s, int ub) {
 	status os = stat[rc];
+	dequeue(rc);
 
 	// Adjust the simple packing sets if necessary. Assignment will certainly
 	// remove 'partialness' so just remove the counts.
@@ -68,8 +117,7 @@ int partial_partition::assign(int rc, status s, int ub) {
 					.remove(free);
 			}
 			if (param.epb) {
-				std::unordered_set<int> &front = partition_front[color];
-				front.erase(front.find(rc));
+				front_erase(color, rc);
 			}
 		}
 	}
@@ -84,6 +132,7 @@ int partial_partition::assign(int rc, status s, int ub) {
 		case status::red:
 		case status::blue: {
 			int color = get_color(s);
+			trail_frames.push_back(trail.size());
 			// Loop over all rows (or columns) that column (or row) `rc`
 			// intersects, to update them.
 			for (const entry &e : m[rc]) {
@@ -92,6 +141,8 @@ int partial_partition::assign(int rc, status s, int ub) {
 				// If the intersecting row/column is already colored, there is
 				// nothing to do.
 				if (is == s) continue;
+				dequeue(e.rc);
+				trail.emplace_back(e.rc, is);
 
 				// Check how many nonzeros are still free.
 				int free = get_free_nonzeros(e.rc);
@@ -116,9 +167,7 @@ int partial_partition::assign(int rc, status s, int ub) {
 					stat[e.rc] = status::implicitly_cut;
 					++implicitly_cut;
 					if (param.epb) {
-						std::unordered_set<int> &front
-							= partition_front[get_color(color_swap(s))];
-						front.erase(front.find(e.rc));
+						front_erase(get_color(color_swap(s)), e.rc);
 					}
 				}
 
@@ -127,7 +176,7 @@ int partial_partition::assign(int rc, status s, int ub) {
 				if (is == status::unassigned) {
 					stat[e.rc] = color_to_partial_status(color);
 					if (param.epb) {
-						partition_front[color].insert(e.rc);
+						front_insert(color, e.rc);
 					}
 				}
 
@@ -136,6 +185,7 @@ int partial_partition::assign(int rc, status s, int ub) {
 					simple_packing_set[e.rc < m.R ? ROWS : COLS][color]
 						.add(free);
 				}
+				enqueue(e.rc);
 			}
 			break;
 		}
@@ -150,6 +200,20 @@ int partial_partition::assign(int rc, status s, int ub) {
 	// We start adjusting the lower bound to see if it exceeds ub.
 	// If we go from implicitly cut to cut, there is no need to recompute
 	// anything!
+	if (param.fb)
+		flow_frames.push_back(vcg.checkpoint());
+	if (param.epb) {
+		// Going from implicitly cut to cut changes nothing the trees of the
+		// extended packing bound depend on, so they carry over.
+		for (int c : {RED, BLUE}) {
+			epb_frame frame{epb_sizes[c].size(), epb_sizes[c].size(), -1,
+				front_version[c]};
+			if (os == status::implicitly_cut && s == status::cut
+					&& !epb_frames[c].empty())
+				frame = epb_frames[c].back();
+			epb_frames[c].push_back(frame);
+		}
+	}
 	if (!(os == status::implicitly_cut && s == status::cut))
 		lower_bound_cache = incremental_lower_bound(rc, s, ub);
 	return lower_bound_cache;
@@ -168,63 +232,44 @@ void partial_partition::undo(int rc, status os) {
 		case status::red:
 		case status::blue: {
 			int color = get_color(s);
-			// Loop over all rows (or columns) that column (or row) `rc`
-			// intersects, to update them.
-			for (const entry &e : m[rc]) {
-				status is = stat[e.rc];
-				
-				// If the intersecting row/column is already colored, there is
-				// nothing to do.
-				if (is == s) continue;
-
-				// Check how many nonzeros are still free.
-				int free = get_free_nonzeros(e.rc);
-				// If using the simple packing bound, remove from packing set.
-				if (param.pb && is_partial(is)) {
-					simple_packing_set[e.rc < m.R ? ROWS : COLS][color]
+			// Revert the rows/columns on the trail in reverse order, each
+			// had a single nonzero colored by this assignment.
+			size_t frame = trail_frames.back();
+			trail_frames.pop_back();
+			while (trail.size() > frame) {
+				int rc2 = trail.back().first;
+				status is = trail.back().second, cs = stat[rc2];
+				trail.pop_back();
+				dequeue(rc2);
+
+				// Remove the current free count from the packing sets, and
+				// the row/column from the front if it leaves it.
+				int free = get_free_nonzeros(rc2);
+				if (param.pb && is_partial(cs)) {
+					simple_packing_set[rc2 < m.R ? ROWS : COLS][get_color(cs)]
 						.remove(free);
 				}
-				// Certainly this nonzero is free again.
-				++free;
+				if (param.epb && cs != is) {
+					if (is_partial(cs))
+						front_erase(get_color(cs), rc2);
+					if (is_partial(is))
+						front_insert(get_color(is), rc2);
+				}
+				if (cs == status::implicitly_cut && is != cs)
+					--implicitly_cut;
 
-				// Otherwise, this entry was certainly not colored, so we
-				// uncolor it.
+				// The nonzero is free again.
 				--partition_size[color];
 				--color_count[color][rc];
-				--color_count[color][e.rc];
-
-				// If the intersecting row/column is implicitly cut but the
-				// entry we are uncoloring was the last of its color, this
-				// row/column becomes partially colored.
-				if (is == status::implicitly_cut &&
-						color_count[color][e.rc] == 0) {
-					stat[e.rc] = to_partial(color_swap(s));
-					--implicitly_cut;
-					if (param.epb) {
-						partition_front[get_color(color_swap(s))]
-							.insert(e.rc);
-					}
-				}
-
-				// If the intersecting row/column is partially colored but the
-				// entry we are uncoloring was the last of its oclor, this row/
-				// column becomes unassigned.
-				if (is == to_partial(s) &&
-						color_count[color][e.rc] == 0) {
-					stat[e.rc] = status::unassigned;
-					if (param.epb) {
-						std::unordered_set<int> &front
-							= partition_front[color];
-						front.erase(front.find(e.rc));
-					}
-				}
+				--color_count[color][rc2];
+				stat[rc2] = is;
 
 				// If the simple packing bound is enabled, add again.
-				if (param.pb && is_partial(stat[e.rc])) {
-					int ocolor = get_color(stat[e.rc]);
-					simple_packing_set[e.rc < m.R ? ROWS : COLS][ocolor]
-						.add(free);
+				if (param.pb && is_partial(is)) {
+					simple_packing_set[rc2 < m.R ? ROWS : COLS][get_color(is)]
+						.add(free + 1);
 				}
+				enqueue(rc2);
 			}
 			break;
 		}
@@ -249,29 +294,31 @@ void partial_partition::undo(int rc, status os) {
 					.add(free);
 			}
 			if (param.epb) {
-				partition_front[color].insert(rc);
+				front_insert(color, rc);
 			}
 		}
 	}
 
-	// Undo the flow bound.
-	if (param.fb) {
-		if (s == status::cut && os != status::implicitly_cut) {
-			vcg.set_activity(rc, vertex_state::active);
-		}
-		if (s == status::red || s == status::blue) {
-			vcg.set_activity(rc, vertex_state::active);
-			for (const entry &e : m[rc]) {
-				if (stat[e.rc] != status::implicitly_cut
-						&& stat[e.rc] != status::cut
-						&& vcg.get_activity(e.rc) == vertex_state::inactive) {
-					vcg.set_activity(e.rc, vertex_state::active);
-				}
-			}
+	// Drop the trees grown for this assignment, if any.
+	if (param.epb) {
+		for (int c : {RED, BLUE}) {
+			const epb_frame &frame = epb_frames[c].back();
+			size_t depth = epb_frames[c].size();
+			if (frame.id >= 0 && (depth == 1
+					|| epb_frames[c][depth - 2].id != frame.id))
+				epb_sizes[c].resize(frame.begin);
+			epb_frames[c].pop_back();
 		}
 	}
 
+	// Undo the flow bound, restoring the flow from before the assignment.
+	if (param.fb) {
+		vcg.rollback(flow_frames.back());
+		flow_frames.pop_back();
+	}
+
 	stat[rc] = os;
+	enqueue(rc);
 }
 
 int partial_partition::incremental_lower_bound(int rc, status s, int ub) {
@@ -307,21 +354,18 @@ int partial_partition::incremental_lower_bound(int rc, status s, int ub) {
 		if (s == status::cut) {
 			vcg.set_activity(rc, vertex_state::inactive);
 		}
-		if (s == status::red) {
-			for (const entry &e : m[rc]) {
-				if (stat[e.rc] == status::implicitly_cut) {
-					vcg.set_activity(e.rc, vertex_state::inactive);
-				}
-			}
-			vcg.set_activity(rc, vertex_state::source);
-		}
-		if (s == status::blue) {
+		if (s == status::red || s == status::blue) {
+			// These changes are passed as a batch, so the flow can be
+			// recomputed at once when many implicitly cut vertices drop out.
+			flow_batch.clear();
 			for (const entry &e : m[rc]) {
 				if (stat[e.rc] == status::implicitly_cut) {
-					vcg.set_activity(e.rc, vertex_state::inactive);
+					flow_batch.emplace_back(e.rc, vertex_state::inactive);
 				}
 			}
-			vcg.set_activity(rc, vertex_state::sink);
+			flow_batch.emplace_back(rc, s == status::red
+				? vertex_state::source : vertex_state::sink);
+			vcg.set_activities(flow_batch);
 		}
 
 		lb_incr = std::max(lb_incr, vcg.get_minimum_vertex_cut());
@@ -330,27 +374,53 @@ int partial_partition::incremental_lower_bound(int rc, status s, int ub) {
 
 	// Extended packing bound.
 	if (param.epb) {
-		// This bound is computed independently from the actual
-		// vertex rc. TODO: perhaps we can gain some speedups by not
-		// recomputing everything here -> only one side needs to be
-		// recomputed?
+		// This bound is computed independently from the actual vertex rc,
+		// but the trees of a side only change if rc or the rows/columns it
+		// changed (directly or through the flow) were near them. So collect
+		// these changes first.
+		epb_changed.clear();
+		epb_changed.push_back(rc);
+		if (s == status::red || s == status::blue) {
+			for (size_t i = trail_frames.back(); i < trail.size(); ++i)
+				if (stat[trail[i].first] != trail[i].second)
+					epb_changed.push_back(trail[i].first);
+		}
+		vcg.changed_since(flow_frames.back(), epb_changed);
+
 		int epbv = 0;
+		int free = m.NZ - partition_size[RED] - partition_size[BLUE];
 		for (int c : {RED, BLUE}) {
-			// We consider side c. We compute (the sizes of) a set of
-			// trees springing from this side.
-			std::vector<int> sizes = grow_trees(c);
-
 			// Let's consider the amount of vertices we'll have to cut.
 			// (note: this code is similar to the simple packing bound
-			//  code)
+			//  code) The trees only hold free nonzeros, so if those all
+			// fit there is no need to grow them.
 			int max_allowed = max_partition_size - partition_size[c];
-			int available = std::accumulate(sizes.begin(), sizes.end(), 0);
+			if (max_allowed >= free) continue;
+
+			// We consider side c. We compute (the sizes of) a set of
+			// trees springing from this side, or reuse those of the
+			// previous assignment.
+			epb_frame &frame = epb_frames[c].back();
+			size_t depth = epb_frames[c].size();
+			if (depth > 1 && epb_can_reuse(c, epb_frames[c][depth - 2])) {
+				frame = epb_frames[c][depth - 2];
+			} else {
+				frame.begin = epb_sizes[c].size();
+				grow_trees(c, epb_sizes[c]);
+				frame.end = epb_sizes[c].size();
+				std::sort(epb_sizes[c].begin() + frame.begin,
+					epb_sizes[c].end(), std::greater<int>());
+				frame.id = epb_last[c];
+			}
+			const int *sizes = epb_sizes[c].data();
+			int available = std::accumulate(sizes + frame.begin,
+				sizes + frame.end, 0);
 			if (max_allowed >= available) continue;
 
 			// We will now start cutting the largest trees as necessary.
 			int min_remove = available - max_allowed;
-			sort(sizes.rbegin(), sizes.rend());
-			for (size_t i = 0; i < sizes.size() && min_remove > 0; ++i) {
+			for (size_t i = frame.begin; i < frame.end && min_remove > 0;
+					++i) {
 				min_remove -= sizes[i];
 				epbv++;
 			}
@@ -365,41 +435,124 @@ int partial_partition::incremental_lower_bound(int rc, status s, int ub) {
 	return lb_base + lb_incr;
 }
 
-std::vector<int> partial_partition::grow_trees(int c) {
+bool partial_partition::epb_can_reuse(int c, const epb_frame &prev) {
+	// The trees must be the last ones grown, and the front the same.
+	if (prev.id < 0 || prev.id != epb_last[c]
+			|| prev.front_version != front_version[c])
+		return false;
+	for (int rc : epb_changed)
+		if (epb_seen[c][rc] == prev.id)
+			return false;
+	return true;
+}
+
+void partial_partition::front_insert(int c, int rc) {
+	partition_front[c].insert(rc);
+	++front_version[c];
+}
+
+void partial_partition::front_erase(int c, int rc) {
+	partition_front[c].erase(rc);
+	++front_version[c];
+}
+
+void partial_partition::enqueue(int rc) {
+	if (stat[rc] == status::implicitly_cut) {
+		implicit_pos[rc] = (int)implicit.size();
+		implicit.push_back(rc);
+	} else if (stat[rc] == status::unassigned || is_partial(stat[rc])) {
+		int free = get_free_nonzeros(rc);
+		bucket_prev[rc] = -1;
+		bucket_next[rc] = bucket_head[free];
+		if (bucket_head[free] >= 0)
+			bucket_prev[bucket_head[free]] = rc;
+		bucket_head[free] = rc;
+		bucket_top = std::max(bucket_top, free);
+	}
+}
+
+void partial_partition::dequeue(int rc) {
+	if (stat[rc] == status::implicitly_cut) {
+		int i = implicit_pos[rc];
+		implicit[i] = implicit.back();
+		implicit_pos[implicit[i]] = i;
+		implicit.pop_back();
+	} else if (stat[rc] == status::unassigned || is_partial(stat[rc])) {
+		if (bucket_prev[rc] >= 0)
+			bucket_next[bucket_prev[rc]] = bucket_next[rc];
+		else
+			bucket_head[get_free_nonzeros(rc)] = bucket_next[rc];
+		if (bucket_next[rc] >= 0)
+			bucket_prev[bucket_next[rc]] = bucket_prev[rc];
+	}
+}
+
+void partial_partition::set_branch_order(const std::vector<int> &order) {
+	// Buckets are filled from the front, so insert in reverse.
+	std::fill(bucket_head.begin(), bucket_head.end(), -1);
+	bucket_top = -1;
+	for (size_t i = order.size(); i-- > 0; )
+		enqueue(order[i]);
+}
+
+int partial_partition::next_branch() {
+	if (!implicit.empty())
+		return implicit.back();
+	while (bucket_top >= 0 && bucket_head[bucket_top] < 0)
+		--bucket_top;
+	return bucket_top >= 0 ? bucket_head[bucket_top] : -1;
+}
+
+void partial_partition::grow_trees(int c, std::vector<int> &sizes) {
 	// This size of the partition springs from partition_size[c].
 	// From each free vertex adjacent to it we grow a tree, trying
 	// to accumulate an even set of subgraphs.
-	
-	// Reset/initialize all required datastructures.
+
+	// The trees are grown one edge at a time, always growing the smallest
+	// one. Only the smallest tree grows (by one), so all trees in the queue
+	// have size k or k+1, and two buckets suffice: tree_head[cur] lists the
+	// trees of size k, tree_head[1-cur] those of size k+1.
+	int tree_head[2] = {-1, -1}, cur = 0, k = 0;
+
+	// Reset/initialize all required datastructures. Every row/column
+	// looked at is marked in epb_seen.
+	long long id = ++epb_last[c];
 	dfs_index.reset_all();
-	dfs_tree_size.reset_all();
-	mp::min_heap<int> dfs_heap;
 	for (int rc : partition_front[c]) {
+		epb_seen[c][rc] = id;
 		if (vcg.is_free(rc)) {
-			dfs_heap.push(key_value<int>{0, rc});
-			dfs_stack[rc].push(rc);
+			dfs_top[rc] = rc;
+			dfs_below[rc] = -1;
+			tree_next[rc] = tree_head[cur];
+			tree_head[cur] = rc;
 			dfs_index.set((size_t)rc, 0);
 		}
 	}
 
 	// Run all DFS's in parallel.
-	while (!dfs_heap.empty()) {
-		// First we grab the smallest tree, its stack, and the currently
-		// active vertex in its DFS. If there are none, remove the tree.
-		int rc = dfs_heap.top().value;
-		std::stack<int> &st = dfs_stack[rc];
-		if (st.empty()) {
-			dfs_heap.pop();
+	while (true) {
+		// First we grab the smallest tree and the currently active vertex
+		// in its DFS. If there is none, the tree is finished.
+		if (tree_head[cur] < 0) {
+			if (tree_head[1 - cur] < 0) break;
+			cur = 1 - cur;
+			++k;
 			continue;
 		}
-		int u = st.top();
+		int rc = tree_head[cur];
+		if (dfs_top[rc] < 0) {
+			tree_head[cur] = tree_next[rc];
+			if (k > 0) sizes.push_back(k);
+			continue;
+		}
+		int u = dfs_top[rc];
 
 		// Consider expanding the next edge from u, if possible. If not, pop.
 		bool claimed_edge = false;
 		while (!claimed_edge) {
 			int index = dfs_index.get((size_t)u);
 			if (index == (int)m[u].size()) {
-				st.pop();
+				dfs_top[rc] = dfs_below[u];
 				break;
 			}
 			dfs_index.set((size_t)u, index+1);
@@ -407,6 +560,7 @@ std::vector<int> partial_partition::grow_trees(int c) {
 			// End point of the edge, and reverse index.
 			int v = m[u][index].rc;
 			int vi = m[u][index].index;
+			epb_seen[c][v] = id;
 
 			// There are several possible states for v. If v is already
 			// colored red or blue we may NOT claim the edge. If it is
@@ -419,8 +573,7 @@ std::vector<int> partial_partition::grow_trees(int c) {
 				// Nothing, it is already red/blue and we can do nothing.
 			} else if (vs == status::cut || vs == status::implicitly_cut
 					|| !vcg.is_free(v)) {
-				// We can claim the edge but not extend. This means
-				// reinserting the stack as well.
+				// We can claim the edge but not extend.
 				claimed_edge = true;
 			} else {
 				// Let's begin by checking the index of the target. If it
@@ -433,30 +586,19 @@ std::vector<int> partial_partition::grow_trees(int c) {
 				if (vsi < 0) {
 					// We can claim the vertex as well! Do it.
 					dfs_index.set((size_t)v, 0);
-					st.push(v);
+					dfs_below[v] = dfs_top[rc];
+					dfs_top[rc] = v;
 				}
 			}
 		}
 
-		// If we claimed an edge, reinsert the stack.
+		// If we claimed an edge, the tree moves to the next bucket.
 		if (claimed_edge) {
-			int sz = dfs_tree_size.get((size_t)rc);
-			dfs_tree_size.set((size_t)rc, sz + 1);
-			dfs_heap.pop();
-			dfs_heap.push(key_value<int>{sz + 1, rc});
+			tree_head[cur] = tree_next[rc];
+			tree_next[rc] = tree_head[1 - cur];
+			tree_head[1 - cur] = rc;
 		}
 	}
-
-	// Aggregate the input: check all partially c vertices on the
-	// front and add their values if >0.
-	std::vector<int> subgraph_sizes;
-	for (int rc : partition_front[c]) {
-		int sz = dfs_tree_size.get(rc);
-		if (sz > 0) {
-			subgraph_sizes.push_back(sz);
-		}
-	}
-	return subgraph_sizes;
 }
 
 status partial_partition::get_status(int rc) const {
@@ -473,6 +615,10 @@ int partial_partition::get_free_nonzeros(int rc) const {
 		- color_count[BLUE][rc];
 }
 
+const flow_stats &partial_partition::get_flow_stats() const {
+	return vcg.get_stats();
+}
+
 int partial_partition::get_guaranteed_lower_bound() const {
 	return cut;
 }
@@ -2,14 +2,14 @@
 #define PARTIAL_PARTITION_H
 
 #include <iostream>
-#include <stack>
-#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "bb-parameters.h"
 #include "../datastructures/matrix.h"
 #include "../datastructures/packing-set.h"
 #include "../datastructures/rvector.h"
+#include "../datastructures/sparse-set.h"
 #include "../datastructures/vertex-cut-graph.h"
 #include "../partitioner/partition-util.h"
 
@@ -41,16 +41,41 @@ class partial_partition {
 	mp::vertex_cut_graph vcg;
 
 	// For the extended packing bound, we maintain a set of all partially
-	// colored rows and columns.
-	std::unordered_set<int> partition_front[2];
+	// colored rows and columns, and count the changes made to each.
+	mp::sparse_set partition_front[2];
+	long long front_version[2] = {0, 0};
+	void front_insert(int c, int rc);
+	void front_erase(int c, int rc);
 
 	// Also for the extended packing bound (for use during the DFS):
-	// For each vertex a stack, a tree-size counter and an index
-	// (explained in the DFS function).
-	// The index vector is quickly resettable so it can be reused for each
-	// DFS.
-	std::vector<std::stack<int>> dfs_stack;
-	mp::rvector<int> dfs_index, dfs_tree_size;
+	// The stacks of all trees share one array: dfs_top holds the top of the
+	// stack of each tree (by its root, -1 if empty) and dfs_below the vertex
+	// below each vertex on its stack. A vertex is on at most one stack, at
+	// most once. tree_next links the trees in the queue of the DFS, and
+	// dfs_index holds an index for each vertex (explained in the DFS
+	// function). The index vector is quickly resettable so it can be reused
+	// for each DFS.
+	std::vector<int> dfs_top, dfs_below, tree_next;
+	mp::rvector<int> dfs_index;
+
+	// The trees grown for the extended packing bound are kept per side and
+	// per assignment, as the range [begin, end) of epb_sizes (sorted from
+	// large to small), with the id of the grow_trees call that found them (or
+	// -1 if none), and the front_version at that point. The trees of the
+	// previous assignment are reused if none of the rows/columns grow_trees
+	// looked at (marked with its id in epb_seen) changed.
+	struct epb_frame {
+		size_t begin, end;
+		long long id, front_version;
+	};
+	std::vector<epb_frame> epb_frames[2];
+	std::vector<int> epb_sizes[2];
+	std::vector<long long> epb_seen[2];
+	long long epb_last[2] = {0, 0};
+
+	// The rows/columns changed by the last assignment (status or flow).
+	std::vector<int> epb_changed;
+	bool epb_can_reuse(int c, const epb_frame &prev);
 
 	// Compute a lower bound on the size of any extension of this partial
 	// partition. Called by assign.
@@ -59,13 +84,43 @@ class partial_partition {
 	// Cache the lower bound, sometimes we do not need to recompute anything.
 	int lower_bound_cache = -1;
 
+	// Trail of the rows/columns (with their old status) of which a nonzero
+	// was colored by a red/blue assignment, so undo can revert exactly those.
+	// trail_frames holds the start of each such assignment on the trail.
+	// Both are preallocated, as at most all nonzeros are colored at once.
+	std::vector<std::pair<int, status>> trail;
+	std::vector<size_t> trail_frames;
+
+	// Checkpoint of the vertex cut graph before each assignment, and the
+	// activity changes of a single assignment.
+	std::vector<int> flow_frames;
+	std::vector<std::pair<int, vertex_state>> flow_batch;
+
+	// Rows/columns that have not been branched on yet, to pick the next
+	// branch from: a list of the implicitly cut ones (implicit_pos is the
+	// index in this list), and buckets of the others by their number of
+	// free nonzeros (doubly linked lists, -1 terminated). No bucket above
+	// bucket_top is in use.
+	std::vector<int> implicit, implicit_pos;
+	std::vector<int> bucket_head, bucket_next, bucket_prev;
+	int bucket_top = -1;
+
+	// Add/remove rc to/from the list or bucket matching its current status
+	// and number of free nonzeros. Does nothing for assigned rows/columns.
+	void enqueue(int rc);
+	void dequeue(int rc);
+
   public:
-	// The matrix partitioned.
-	const matrix &m;
+	// The matrix partitioned (sharing the storage of the one given).
+	matrix m;
 
 	partial_partition(const matrix &_m, bbparameters _param,
 		int _max_partition_size);
 
+	// Start over on another matrix, with nothing assigned, reusing the
+	// memory held for the previous one.
+	void reset(const matrix &_m, int _max_partition_size);
+
 	// Whether or not a status can be assigned to the given row/column.
 	bool can_assign(int rc, status s) const;
 
@@ -88,10 +143,19 @@ class partial_partition {
 	//	}
 	void undo(int rc, status os);
 
-	// Grow a set of trees from the given side of the partition and return
-	// their sizes. Based on the current state of the partition and vertex
-	// cut graph.
-	std::vector<int> grow_trees(int c);
+	// Set the order in which rows/columns with equally many free nonzeros
+	// are branched on. Only valid while nothing has been assigned.
+	void set_branch_order(const std::vector<int> &order);
+
+	// The row/column to branch on next: an implicitly cut one if any,
+	// otherwise one with the most free nonzeros. Returns -1 if all rows/
+	// columns have been assigned.
+	int next_branch();
+
+	// Grow a set of trees from the given side of the partition and append
+	// their sizes to the given vector. Based on the current state of the
+	// partition and vertex cut graph.
+	void grow_trees(int c, std::vector<int> &sizes);
 
 	// Status of the given row/column.
 	status get_status(int rc) const;
@@ -105,6 +169,9 @@ class partial_partition {
 	// How many actual rows/columns have been cut (no lowerbounding).
 	int get_guaranteed_lower_bound() const;
 
+	// How the flow bound processed its updates.
+	const flow_stats &get_flow_stats() const;
+
 	// Friend for debugging.
 	friend void print_ppmatrix(std::ostream &stream,
 		const partial_partition &pp);
@@ -1,6 +1,5 @@
 #include "./matrix-util.h"
 
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -8,11 +7,12 @@
 
 namespace mp {
 
-matrix compress(const matrix &m, std::unordered_map<int, int> &idm) {
+matrix compress(const matrix &m, std::vector<int> &idm) {
 	int nR = 0, nC = 0;
+	idm.assign(m.R + m.C, -1);
 	for (int id = 0; id < m.R + m.C; ++id) {
 		if (m[id].size() > 0) {
-			idm.emplace(id, (int)idm.size());
+			idm[id] = nR + nC;
 			(id < m.R ? nR : nC)++;
 		}
 	}
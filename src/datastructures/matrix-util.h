@@ -1,7 +1,7 @@
 #ifndef MATRIX_UTIL_H
 #define MATRIX_UTIL_H
 
-#include <unordered_map>
+#include <vector>
 
 #include "./matrix.h"
 
@@ -10,8 +10,9 @@ namespace mp {
 constexpr int ROWS = 0, COLS = 1;
 
 // Row/column compressed version of the given matrix. Returns a new matrix
-// without empty rows or columns.
-matrix compress(const matrix &m, std::unordered_map<int, int> &idm);
+// without empty rows or columns. idm[i] is the row/column of the new matrix
+// that row/column i became, or -1 if it was removed.
+matrix compress(const matrix &m, std::vector<int> &idm);
 
 }
 
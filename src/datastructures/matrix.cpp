@@ -6,27 +6,122 @@
 
 namespace mp {
 
+namespace {
+
+// Storage of a matrix constructed in memory: a single block holding the
+// offsets (R + C + 1 ints), followed by the entries (2 * NZ).
+struct matrix_storage {
+	std::unique_ptr<int[]> block;
+
+	matrix_storage(int R, int C, int NZ)
+		: block(new int[R + C + 1 + 4 * (size_t)NZ]()) {}
+};
+
+// Given the columns filled with their rows in order, and next[r] pointing at
+// the start of every row r, fill the rows (in order) and link the entries.
+void fill_rows(int R, int C, const int *first, entry *entries,
+		std::vector<int> &next) {
+	// Bucket by row, going over the columns in order, so the rows are sorted.
+	for (int c = R; c < R + C; ++c)
+		for (int i = first[c]; i < first[c + 1]; ++i)
+			entries[next[entries[i].rc]++].rc = c;
+
+	// Going over the rows in order, fill the columns again, now sorted, and
+	// link the entries.
+	std::copy(first + R, first + R + C, next.begin() + R);
+	for (int r = 0; r < R; ++r) {
+		for (int i = first[r]; i < first[r + 1]; ++i) {
+			int c = entries[i].rc;
+			int ci = next[c] - first[c];
+			entries[next[c]++] = entry{r, i - first[r]};
+			entries[i].index = ci;
+		}
+	}
+}
+
+}
+
 matrix::matrix(int _R, int _C, std::vector<std::pair<int, int>> &nonzeros) {
 	R = _R;
 	C = _C;
 	NZ = (int)nonzeros.size();
+	Cmax = 0;
 
-	adj.resize(R + C);
+	auto st = std::make_shared<matrix_storage>(R, C, NZ);
+	int *_first = st->block.get();
+	entry *_entries = reinterpret_cast<entry *>(_first + R + C + 1);
 
-	std::sort(nonzeros.begin(), nonzeros.end());
+	// Count the nonzeros of every row and column.
+	// Identifiers [0, R) are reserved for rows, [R, R+C) for the columns.
 	for (std::pair<int, int> nz : nonzeros) {
-		// Identifiers [0, R) are reserved for rows, [R, R+C) for the columns.
-		int _r = nz.first, _c = R + nz.second;
-		int _ri = (int)adj[_r].size();
-		int _ci = (int)adj[_c].size();
-
-		adj[_r].emplace_back(entry{_c, _ci});
-		adj[_c].emplace_back(entry{_r, _ri});
-		
-		Cmax = std::max(Cmax, std::max(
-			(int)adj[_r].size(),
-			(int)adj[_c].size()));
+		++_first[nz.first + 1];
+		++_first[R + nz.second + 1];
+	}
+	for (int i = 0; i < R + C; ++i) {
+		Cmax = std::max(Cmax, _first[i + 1]);
+		_first[i + 1] += _first[i];
+	}
+
+	// Sort the nonzeros by bucketing them twice. First by column, after
+	// which the nonzeros are no longer needed, then by row.
+	std::vector<int> next(_first, _first + R + C);
+	for (std::pair<int, int> nz : nonzeros)
+		_entries[next[R + nz.second]++].rc = nz.first;
+	std::vector<std::pair<int, int>>().swap(nonzeros);
+	fill_rows(R, C, _first, _entries, next);
+
+	first = _first;
+	entries = _entries;
+	storage = st;
+}
+
+matrix::matrix(int _R, int _C, const int *row_ptr, const int *col_idx,
+		std::vector<int> &ids) {
+	// Number the nonempty rows, then the nonempty columns.
+	std::vector<int> idm(_R + _C, 0);
+	for (int r = 0; r < _R; ++r)
+		idm[r] = row_ptr[r + 1] - row_ptr[r];
+	for (int k = row_ptr[0]; k < row_ptr[_R]; ++k)
+		++idm[_R + col_idx[k]];
+	ids.clear();
+	R = C = 0;
+	for (int id = 0; id < _R + _C; ++id) {
+		int count = idm[id];
+		idm[id] = count > 0 ? (int)ids.size() : -1;
+		if (count > 0) {
+			ids.push_back(id);
+			(id < _R ? R : C)++;
+		}
+	}
+	NZ = row_ptr[_R] - row_ptr[0];
+	Cmax = 0;
+
+	auto st = std::make_shared<matrix_storage>(R, C, NZ);
+	int *_first = st->block.get();
+	entry *_entries = reinterpret_cast<entry *>(_first + R + C + 1);
+
+	for (int r = 0; r < _R; ++r) {
+		for (int k = row_ptr[r]; k < row_ptr[r + 1]; ++k) {
+			++_first[idm[r] + 1];
+			++_first[idm[_R + col_idx[k]] + 1];
+		}
+	}
+	for (int i = 0; i < R + C; ++i) {
+		Cmax = std::max(Cmax, _first[i + 1]);
+		_first[i + 1] += _first[i];
 	}
+
+	// Bucket the nonzeros by column, going over the rows in order, then by
+	// row.
+	std::vector<int> next(_first, _first + R + C);
+	for (int r = 0; r < _R; ++r)
+		for (int k = row_ptr[r]; k < row_ptr[r + 1]; ++k)
+			_entries[next[idm[_R + col_idx[k]]]++].rc = idm[r];
+	fill_rows(R, C, _first, _entries, next);
+
+	first = _first;
+	entries = _entries;
+	storage = st;
 }
 
 matrix::matrix(int _R, int _C) {
@@ -34,7 +129,17 @@ matrix::matrix(int _R, int _C) {
 	C = _C;
 	NZ = 0;
 	Cmax = 0;
-	adj.resize(R + C);
+
+	auto st = std::make_shared<matrix_storage>(R, C, 0);
+	first = st->block.get();
+	entries = reinterpret_cast<entry *>(st->block.get() + R + C + 1);
+	storage = st;
+}
+
+matrix::matrix(int _R, int _C, int _NZ, int _Cmax, const int *_first,
+		const entry *_entries, std::shared_ptr<const void> owner)
+		: R(_R), C(_C), NZ(_NZ), Cmax(_Cmax), first(_first),
+		entries(_entries), storage(owner) {
 }
 
 std::ostream &operator<<(std::ostream &stream, const matrix &m) {
@@ -42,8 +147,4 @@ std::ostream &operator<<(std::ostream &stream, const matrix &m) {
 	return stream;
 }
 
-const std::vector<entry> &matrix::operator[](int index) const {
-	return adj[index];
-}
-
 }
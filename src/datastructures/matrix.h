@@ -1,7 +1,9 @@
 #ifndef MATRIX_H
 #define MATRIX_H
 
+#include <cstddef>
 #include <iostream>
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -15,11 +17,24 @@ struct entry {
 	int index;
 };
 
-struct matrix {
+// The entries of a single row or column.
+class entry_range {
 public:
-	// The entries of the matrix, by row and column.
-	std::vector<std::vector<entry>> adj;
+	entry_range(const entry *_first, const entry *_last)
+		: first(_first), last(_last) {}
+
+	const entry *begin() const { return first; }
+	const entry *end() const { return last; }
+	size_t size() const { return last - first; }
+	bool empty() const { return first == last; }
+	const entry &operator[](size_t i) const { return first[i]; }
 
+private:
+	const entry *first, *last;
+};
+
+struct matrix {
+public:
 	// The number of rows and columns in the matrix.
 	int R, C;
 	// The number of nonzeros in the matrix.
@@ -27,17 +42,45 @@ public:
 	// The maximal number of nonzeros in a single row or column.
 	int Cmax;
 
-	// Construct a matrix from a given set of nonzeros.
+	// Construct a matrix from a given set of nonzeros, in O(R + C + NZ)
+	// time. The nonzeros are released as soon as they are no longer needed,
+	// leaving the vector empty.
 	matrix(int _R, int _C, std::vector<std::pair<int, int>> &nonzeros);
 
+	// Construct a matrix from borrowed arrays in CSR format, in O(R + C + NZ)
+	// time: row r has the nonzeros in the columns col_idx[row_ptr[r]], ...,
+	// col_idx[row_ptr[r + 1] - 1]. Empty rows and columns are left out, and
+	// ids[i] is set to the row (or R + the column) that row/column i came
+	// from. The arrays are assumed to be valid, without duplicates.
+	matrix(int _R, int _C, const int *row_ptr, const int *col_idx,
+		std::vector<int> &ids);
+
 	// Empty matrix constructor (for convenience).
 	matrix(int _R, int _C);
 
+	// Construct a matrix on top of existing storage in the layout described
+	// below, without copying it. The storage is kept alive by owner.
+	matrix(int _R, int _C, int _NZ, int _Cmax, const int *_first,
+		const entry *_entries, std::shared_ptr<const void> owner);
+
 	// Overload IO operator.
 	friend std::ostream &operator<<(std::ostream &stream, const matrix &m);
 
 	// Index the matrix by [row/column identifier].
-	const std::vector<entry> &operator[](int index) const;
+	entry_range operator[](int index) const {
+		return entry_range(entries + first[index], entries + first[index + 1]);
+	}
+
+	// The entries of the matrix, by row and column: those of row/column i
+	// are entries()[first()[i]], ..., entries()[first()[i + 1] - 1].
+	const int *offsets() const { return first; }
+	const entry *data() const { return entries; }
+
+private:
+	// The storage is never modified, so copies of the matrix share it.
+	const int *first;
+	const entry *entries;
+	std::shared_ptr<const void> storage;
 };
 
 }
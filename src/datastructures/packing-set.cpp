@@ -1,24 +1,45 @@
 #include "./packing-set.h"
 
-#include <algorithm>
-
 namespace mp {
 
+packing_set::packing_set(int _max_value) {
+	assign(_max_value);
+}
+
+void packing_set::assign(int _max_value) {
+	count_tree.assign(_max_value + 1, 0);
+	sum_tree.assign(_max_value + 1, 0);
+	max_value = _max_value;
+	top_bit = 1;
+	while (2 * top_bit <= max_value)
+		top_bit *= 2;
+	C = 0;
+	ps_size = -1;
+	total = 0;
+	elements = 0;
+}
+
 void packing_set::add(int c) {
-	values[c]++;
+	update(c, 1);
 	ps_size = -1;
 	total += c;
 }
 
 void packing_set::remove(int c) {
-	auto it = values.find(c);
-	it->second--;
-	if (it->second == 0)
-		values.erase(it);
+	update(c, -1);
 	ps_size = -1;
 	total -= c;
 }
 
+void packing_set::update(int c, int delta) {
+	if (c <= 0) return;
+	elements += delta;
+	for (int i = max_value + 1 - c; i <= max_value; i += i & -i) {
+		count_tree[i] += delta;
+		sum_tree[i] += delta * c;
+	}
+}
+
 void packing_set::set_lower_bound(int nC) {
 	C = nC;
 	ps_size = -1;
@@ -31,13 +52,29 @@ int packing_set::get_minimum_packing_set_size() {
 }
 
 void packing_set::recompute() {
-	int ps = 0;
-	ps_size = 0;
-	for (auto it = values.rbegin(); ps < C && it != values.rend(); ++it) {
-		int use = std::min(it->second, (C - ps + it->first - 1) / it->first);
-		ps_size += use;
-		ps += use * it->first;
+	// Greedily taking the largest values first is optimal.
+	if (C <= 0) {
+		ps_size = 0;
+		return;
+	}
+	if (total < C) {
+		ps_size = elements;
+		return;
+	}
+
+	// Find the longest prefix (i.e. the largest values) summing to < C. All
+	// of these are used, and the remainder is covered by the next value.
+	int pos = 0, count = 0, sum = 0;
+	for (int bit = top_bit; bit > 0; bit /= 2) {
+		int next = pos + bit;
+		if (next <= max_value && sum + sum_tree[next] < C) {
+			pos = next;
+			count += count_tree[next];
+			sum += sum_tree[next];
+		}
 	}
+	int c = max_value - pos;
+	ps_size = count + (C - sum + c - 1) / c;
 }
 
 int packing_set::total_sum() const {
@@ -1,18 +1,25 @@
 #ifndef PACKING_SET_H
 #define PACKING_SET_H
 
-#include <map>
+#include <vector>
 
 namespace mp {
 
 // A datastructure for dynamically maintaining a 'packing set'.
 // Specifically, this datastructure maintains a multiset of integers
-// as well as a lowerbound C, and can return the size of the smallest
-// subset of the multiset that sums to >= C.
+// in [0, max_value] as well as a lowerbound C, and can return the size
+// of the smallest subset of the multiset that sums to >= C.
 
 class packing_set {
 
 public:
+	packing_set() = default;
+	explicit packing_set(int max_value);
+
+	// Empty the multiset and the lowerbound, for values in [0, max_value],
+	// reusing the memory held.
+	void assign(int max_value);
+
 	// Add/remove integers.
 	void add(int c);
 	void remove(int c);
@@ -26,9 +33,16 @@ public:
 	int total_sum() const;
 
 private:
-	std::map<int, int> values;
-	int C = 0, ps_size = -1, total = 0;
+	// Fenwick trees with the count and the sum of the values, indexed in
+	// decreasing order of value: position i holds value max_value + 1 - i,
+	// so prefixes are the largest values. Zeroes are not stored, as they
+	// never contribute to a packing set.
+	std::vector<int> count_tree, sum_tree;
+	int max_value = 0, top_bit = 0;
+
+	int C = 0, ps_size = -1, total = 0, elements = 0;
 
+	void update(int c, int delta);
 	void recompute();
 };
 
@@ -26,6 +26,13 @@ public:
 
 	// Functions are implemented here due to template logic.
 
+	// Resize to N default values, reusing the memory held.
+	void assign(size_t N) {
+		value.assign(N, def);
+		timestamp.assign(N, 0);
+		current_time = 0;
+	}
+
 	T get(size_t i) const {
 		return current_time == timestamp[i] ? value[i] : def;
 	}
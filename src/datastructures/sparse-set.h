@@ -0,0 +1,51 @@
+#ifndef SPARSE_SET_H
+#define SPARSE_SET_H
+
+#include <vector>
+
+namespace mp {
+
+// A set of integers in [0, N), stored densely: the members are kept in a
+// contiguous list and pos holds the index of each value in this list (-1 if
+// it is not a member). Erasing moves the last member into the gap, so the
+// iteration order only depends on the sequence of insertions and erasures.
+class sparse_set {
+private:
+	std::vector<int> list, pos;
+
+public:
+	sparse_set() = default;
+	explicit sparse_set(size_t N) { assign(N); }
+
+	// Make this the empty set on [0, N), reusing the memory held.
+	void assign(size_t N) {
+		list.clear();
+		list.reserve(N);
+		pos.assign(N, -1);
+	}
+
+	bool contains(int v) const { return pos[v] >= 0; }
+	size_t size() const { return list.size(); }
+	bool empty() const { return list.empty(); }
+
+	std::vector<int>::const_iterator begin() const { return list.begin(); }
+	std::vector<int>::const_iterator end() const { return list.end(); }
+
+	// Insert v, which must not be a member.
+	void insert(int v) {
+		pos[v] = (int)list.size();
+		list.push_back(v);
+	}
+	// Erase v, which must be a member.
+	void erase(int v) {
+		int i = pos[v], last = list.back();
+		list[i] = last;
+		pos[last] = i;
+		pos[v] = -1;
+		list.pop_back();
+	}
+};
+
+}
+
+#endif
@@ -1,31 +1,77 @@
 #include "./vertex-cut-graph.h"
 
 #include <algorithm>
-#include <queue>
 
 namespace mp {
 
-vertex_cut_graph::vertex_cut_graph(const matrix &m) : V(2 * (m.R + m.C)),
-		par(V, -1), pari(V, -1) {
+// Number of deactivated vertices carrying flow from which on a batch of
+// activity changes is processed by recomputing the flow.
+constexpr int BATCH_RECOMPUTE = 4;
+
+vertex_cut_graph::vertex_cut_graph(const matrix &m) : sources(0), sinks(0),
+		reroute(0), par(0, -1), pari(0, -1), level(0, -1) {
+	reset(m);
+}
+
+void vertex_cut_graph::reset(const matrix &m) {
+	V = 2 * (m.R + m.C);
+	flow = 0;
+	sources.assign(V);
+	sinks.assign(V);
+	reroute.assign(V);
+	par.assign(V);
+	pari.assign(V);
+	queue.resize(V);
+	level.assign(V);
+	current.resize(V);
+	carrying.clear();
+	log.clear();
+	frames.clear();
+	path.clear();
+	stats = flow_stats();
 	state.assign(m.R + m.C, vertex_state::active);
-	graph.resize(V);
+
+	// Count the edges leaving each vertex: the passthrough edge and its
+	// residual, and per nonzero two external edges and their residuals.
+	first.assign(V + 1, 0);
 	for (int u = 0; u < m.R + m.C; ++u) {
-		add_edge(inv(u), outv(u), 1);
+		first[inv(u) + 1] += 1 + (int32_t)m[u].size();
+		first[outv(u) + 1] += 1 + (int32_t)m[u].size();
+	}
+	for (int u = 0; u < V; ++u)
+		first[u + 1] += first[u];
+	head.resize(first[V]);
+	rev.resize(first[V]);
+	cross.resize(first[V]);
+	edge_flow.assign(first[V], 0);
+	edge_cap.resize(first[V]);
+	carrying_pos.assign(first[V], -1);
+	// Of an edge and its residual at most one carries flow.
+	carrying.reserve(first[V] / 2);
+
+	// Reserve room for the log up front, typically it does not grow beyond
+	// this during the search.
+	log.reserve(first[V]);
+	frames.reserve(m.R + m.C + 1);
+	path.reserve(V);
+
+	// Passthrough edges go first.
+	std::vector<int32_t> next(first.begin(), first.end() - 1);
+	for (int u = 0; u < m.R + m.C; ++u) {
+		add_edge(next, inv(u), outv(u), 1);
 	}
 	for (int u = 0; u < m.R; ++u) {
 		for (const entry &e : m[u]) {
-			int uos = (int)graph[outv(u)].size();
-			int ercos = (int)graph[outv(e.rc)].size();
-			add_edge(outv(u), inv(e.rc), 1, ercos);
-			add_edge(outv(e.rc), inv(u), 1, uos);
+			int uos = next[outv(u)], ercos = next[outv(e.rc)];
+			add_edge(next, outv(u), inv(e.rc), 1, ercos);
+			add_edge(next, outv(e.rc), inv(u), 1, uos);
 		}
 	}
 }
 
 bool vertex_cut_graph::is_free(int u) const {
 	bool is_active = (get_activity(u) == vertex_state::active);
-	int ui = inv(u);
-	bool has_flow = (graph[ui][0].flow > 0);
+	bool has_flow = (edge_flow[first[inv(u)]] > 0);
 	return is_active && !has_flow;
 }
 
@@ -33,6 +79,7 @@ void vertex_cut_graph::set_activity(int u, vertex_state s) {
 	if (get_activity(u) == s) return;
 
 	int ui = inv(u), uo = outv(u);
+	record(change_type::state, u, 0, (int)state[u]);
 
 	// In principle we only have switches between 'source/inactive/sink' and
 	// 'active'.
@@ -41,16 +88,18 @@ void vertex_cut_graph::set_activity(int u, vertex_state s) {
 	if (get_activity(u) == vertex_state::active
 			&& s == vertex_state::inactive) {
 		// Mark as inactive and remove passthrough edge.
-		bool has_flow = graph[ui][0].flow > 0;
+		bool has_flow = edge_flow[first[ui]] > 0;
 		if (has_flow)
-			adjust_flow(ui, 0, -1);
-		graph[ui][0].cap = graph[uo][0].cap = 0;
+			adjust_flow(first[ui], -1);
+		record(change_type::capacity, u, 0, edge_cap[first[ui]]);
+		edge_cap[first[ui]] = edge_cap[first[uo]] = 0;
 
 		// If there was flow we have to reroute or cancel it.
 		if (has_flow) {
 			// First try rerouting ...
-			std::unordered_map<int, int> T{{uo, 0}};
-			if (push(ui, T, 1) == 0) {
+			reroute.clear();
+			reroute.set(uo, 0);
+			if (push(ui, reroute, 1) == 0) {
 				// Rerouting failed, now we push back.
 				push(ui, sources, -1);
 				pull(uo, sinks, -1);
@@ -66,14 +115,15 @@ void vertex_cut_graph::set_activity(int u, vertex_state s) {
 			&& s == vertex_state::active) {
 		// Reenable u.
 		state[u] = s;
-		graph[ui][0].cap = 1;
+		record(change_type::capacity, u, 0, edge_cap[first[ui]]);
+		edge_cap[first[ui]] = 1;
 		
 		// Try pulling to ui.
 		if (pull(ui, sources, 1)) {
 			// Try pushing from uo.
 			if (push(uo, sinks, 1)) {
 				// Success, now adjust flow.
-				adjust_flow(ui, 0, 1);
+				adjust_flow(first[ui], 1);
 				flow += 1;
 			} else {
 				// Failure, reroute ui flow.
@@ -91,7 +141,8 @@ void vertex_cut_graph::set_activity(int u, vertex_state s) {
 		while (push(uo, sinks, 1) > 0) ++inc;
 
 		flow += inc;
-		sources[uo] = inc;
+		record_terminal(sources, uo);
+		sources.set(uo, inc);
 	}
 	// source => active
 	else if (get_activity(u) == vertex_state::source
@@ -99,8 +150,9 @@ void vertex_cut_graph::set_activity(int u, vertex_state s) {
 		state[u] = s;
 
 		// First try rerouting as much flow as possible.
-		int debit = sources[uo];
-		sources.erase(sources.find(uo));
+		int debit = sources.get(uo);
+		record_terminal(sources, uo);
+		sources.erase(uo);
 		while (debit > 0 && pull(uo, sources, 1) > 0) --debit;
 
 		// Whatever is left we need to pull back to the sinks.
@@ -116,7 +168,8 @@ void vertex_cut_graph::set_activity(int u, vertex_state s) {
 		while (pull(ui, sources, 1) > 0) ++inc;
 
 		flow += inc;
-		sinks[ui] = inc;
+		record_terminal(sinks, ui);
+		sinks.set(ui, inc);
 	}
 	// sink => active
 	else if (get_activity(u) == vertex_state::sink
@@ -124,8 +177,9 @@ void vertex_cut_graph::set_activity(int u, vertex_state s) {
 		state[u] = s;
 
 		// First try rerouting as much flow as possible.
-		int debit = sinks[ui];
-		sinks.erase(sinks.find(ui));
+		int debit = sinks.get(ui);
+		record_terminal(sinks, ui);
+		sinks.erase(ui);
 		while (debit > 0 && push(ui, sinks, 1) > 0) --debit;
 
 		// Whatever is left we need to push back to the sources.
@@ -137,12 +191,66 @@ void vertex_cut_graph::set_activity(int u, vertex_state s) {
 	// irregularity of the udpates. So we periodically clear the graph.
 	// This is easiest to detect when the flow is 0 but there are edges
 	// that have flow going through them. In this case we can simply zero
-	// all flow edges.
-	if (flow == 0 && magnitude > 0) {
-		for (int u = 0; u < V; ++u)
-			for (internal_edge &e : graph[u])
-				e.flow = 0;
-		magnitude = 0;
+	// the edges carrying flow.
+	clear_stray_flow();
+}
+
+void vertex_cut_graph::set_activities(
+		const std::vector<std::pair<int, vertex_state>> &batch) {
+	// Recomputing only pays off if many deactivated vertices carry flow, and
+	// only deactivations and new sources/sinks are supported.
+	int carrying = 0;
+	bool supported = true;
+	for (const auto &change : batch) {
+		vertex_state os = get_activity(change.first);
+		if (os == change.second) continue;
+		if (os != vertex_state::active || change.second == vertex_state::active)
+			supported = false;
+		else if (change.second == vertex_state::inactive
+				&& edge_flow[first[inv(change.first)]] > 0)
+			++carrying;
+	}
+	if (!supported || carrying < BATCH_RECOMPUTE) {
+		++stats.incremental;
+		for (const auto &change : batch)
+			set_activity(change.first, change.second);
+		return;
+	}
+
+	++stats.recomputed;
+	for (const auto &change : batch) {
+		int u = change.first, ui = inv(u), uo = outv(u);
+		if (get_activity(u) == change.second) continue;
+		record(change_type::state, u, 0, (int)state[u]);
+		if (change.second == vertex_state::inactive) {
+			if (edge_flow[first[ui]] > 0)
+				cancel(u);
+			record(change_type::capacity, u, 0, edge_cap[first[ui]]);
+			edge_cap[first[ui]] = edge_cap[first[uo]] = 0;
+		} else if (change.second == vertex_state::source) {
+			record_terminal(sources, uo);
+			sources.set(uo, 0);
+		} else {
+			record_terminal(sinks, ui);
+			sinks.set(ui, 0);
+		}
+		state[u] = change.second;
+	}
+	augment();
+	clear_stray_flow();
+}
+
+const flow_stats &vertex_cut_graph::get_stats() const {
+	return stats;
+}
+
+void vertex_cut_graph::clear_stray_flow() {
+	if (flow > 0) return;
+
+	// Only the edges on stray cycles carry flow now.
+	while (!carrying.empty()) {
+		int i = carrying.back();
+		adjust_flow(i, -edge_flow[i]);
 	}
 }
 
@@ -155,147 +263,330 @@ int vertex_cut_graph::get_minimum_vertex_cut() const {
 	return flow;
 }
 
-int vertex_cut_graph::push(int s, std::unordered_map<int, int> &T, int c) {
+int vertex_cut_graph::push(int s, terminal_set &T, int c) {
 	if (T.empty()) return 0;
-	std::queue<int> q;
+	int qhead = 0, qtail = 0;
 	par.reset_all();
 	pari.reset_all();
 
 	// Enqueue s, marking it's parent as -2 to signify it as a source.
-	q.push(s);
+	queue[qtail++] = s;
 	par.set(s, -2);
 
 	// Do a BFS to find a feasible sink.
 	int t = -1;
-	while (!q.empty()) {
-		int u = q.front();
-		q.pop();
+	while (qhead < qtail) {
+		int u = queue[qhead++];
 
-		auto it = T.find(u);
-		if (it != T.end() && it->second + c >= 0) {
+		if (T.contains(u) && T.get(u) + c >= 0) {
 			t = u;
 			break;
 		}
 
-		for (int i = 0; i < (int)graph[u].size(); ++i) {
-			const internal_edge &e = graph[u][i];
-			if (e.flow >= e.cap) continue;
-			if (state[lift(e.v)] == vertex_state::inactive) continue;
-			if (par.get(e.v) != -1) continue;
-			if (e.flow == 0 && c < 0) continue;
+		for (int i = first[u]; i < first[u + 1]; ++i) {
+			int v = head[i];
+			if (edge_flow[i] >= edge_cap[i]) continue;
+			if (state[lift(v)] == vertex_state::inactive) continue;
+			if (par.get(v) != -1) continue;
+			if (edge_flow[i] == 0 && c < 0) continue;
 
-			par.set(e.v, u);
-			pari.set(e.v, i);
-			q.push(e.v);
+			par.set(v, u);
+			pari.set(v, i);
+			queue[qtail++] = v;
 		}
 	}
 
 	if (t < 0) return 0;
 	
-	T[t] += c;
+	record_terminal(T, t);
+	T.set(t, T.get(t) + c);
 	while (t != s) {
 		int p = par.get(t), pi = pari.get(t);
-		adjust_flow(p, pi, 1);
-		// Avoid positive-flow cycles of the form:
-		// outv(u) -> inv(v) -> outv(v) -> inv(u) -> ...
-		if (graph[p][pi].crossid >= 0) {
-			// This implies p is the outvertex and t an invertex. If the
-			// cross edge has flow and the internal edges of p/2 and t/2
-			// also do, we can cancel out this cycle.
-			int pin = inv(lift(p)), tout = outv(lift(t));
-			int cid = graph[p][pi].crossid;
-			if (graph[t][0].flow > 0 && graph[tout][cid].flow > 0
-					&& graph[pin][0].flow > 0) {
-				adjust_flow(p, pi, -1);
-				adjust_flow(t, 0, -1);
-				adjust_flow(tout, cid, -1);
-				adjust_flow(pin, 0, -1);
-			}
-		}
+		adjust_flow(pi, 1);
+		cancel_cycle(pi);
 		t = p;
 	}
 
 	return c;
 }
 
-int vertex_cut_graph::pull(int t, std::unordered_map<int, int> &S, int c) {
+int vertex_cut_graph::pull(int t, terminal_set &S, int c) {
 	if (S.empty()) return 0;
-	std::queue<int> q;
+	int qhead = 0, qtail = 0;
 	par.reset_all();
 	pari.reset_all();
 
 	// Enqueue s, marking it's parent as -2 to signify it as a sink.
-	q.push(t);
+	queue[qtail++] = t;
 	par.set(t, -2);
 
 	// Do a BFS to find a feasible source.
 	int s = -1;
-	while (!q.empty()) {
-		int u = q.front();
-		q.pop();
+	while (qhead < qtail) {
+		int u = queue[qhead++];
 
-		auto it = S.find(u);
-		if (it != S.end() && it->second + c >= 0) {
+		if (S.contains(u) && S.get(u) + c >= 0) {
 			s = u;
 			break;
 		}
 
-		for (int i = 0; i < (int)graph[u].size(); ++i) {
-			// Note distinction between e and re!!!
-			const internal_edge &e = graph[u][i];
-			const internal_edge &re = graph[e.v][e.rev];
-			if (re.flow >= re.cap) continue;
-			if (state[lift(e.v)] == vertex_state::inactive) continue;
-			if (par.get(e.v) != -1) continue;
-			if (re.flow == 0 && c < 0) continue;
-
-			par.set(e.v, u);
-			pari.set(e.v, i);
-			q.push(e.v);
+		for (int i = first[u]; i < first[u + 1]; ++i) {
+			// Note distinction between i and its residual ri!!!
+			int v = head[i], ri = rev[i];
+			if (edge_flow[ri] >= edge_cap[ri]) continue;
+			if (state[lift(v)] == vertex_state::inactive) continue;
+			if (par.get(v) != -1) continue;
+			if (edge_flow[ri] == 0 && c < 0) continue;
+
+			par.set(v, u);
+			pari.set(v, i);
+			queue[qtail++] = v;
 		}
 	}
 
 	if (s < 0) return 0;
 
-	S[s] += c;
+	record_terminal(S, s);
+	S.set(s, S.get(s) + c);
 	while (s != t) {
 		int p = par.get(s), pi = pari.get(s);
-		adjust_flow(p, pi, -1);
-		// Avoid positive-flow cycles of the form:
-		// outv(u) -> inv(v) -> outv(v) -> inv(u) -> ...
-		// Since we are now pulling from p_pi we are pushing on
-		// the reverse edge. So we consider an edge-cycle containing
-		// the reverse edge: this reverse edge is (s, graph[p][pi].rev)
-		int si = graph[p][pi].rev;
-		if (graph[s][si].crossid >= 0) {
-			// This implies s is the outvertex and p an invertex. If the
-			// cross edge has flow and the internal edges of s/2 and p/2
-			// also do, we can cancel out this cycle.
-			int pout = outv(lift(p)), sin = inv(lift(s));
-			int cid = graph[s][si].crossid;
-			if (graph[p][0].flow > 0 && graph[pout][cid].flow > 0
-					&& graph[sin][0].flow > 0) {
-				adjust_flow(s, si, -1);
-				adjust_flow(p, 0, -1);
-				adjust_flow(pout, cid, -1);
-				adjust_flow(sin, 0, -1);
-			}
-		}
+		adjust_flow(pi, -1);
+		// Since we are now pulling from pi we are pushing on the reverse
+		// edge, which may close a cycle.
+		cancel_cycle(rev[pi]);
 		s = p;
 	}
 
 	return c;
 }
 
-void vertex_cut_graph::add_edge(int u, int v, int cap, int cid) {
-	graph[u].emplace_back(v, (int)graph[v].size(), cap, cid);
-	graph[v].emplace_back(u, (int)graph[u].size()-1, 0);
+void vertex_cut_graph::cancel_cycle(int ei) {
+	// Avoid positive-flow cycles of the form:
+	// outv(u) -> inv(v) -> outv(v) -> inv(u) -> ...
+	if (cross[ei] < 0) return;
+
+	// This implies the tail p of ei is an outvertex and its head t an
+	// invertex. If the cross edge has flow and the internal edges of p/2 and
+	// t/2 also do, we can cancel out this cycle.
+	int t = head[ei], pin = inv(lift(head[rev[ei]]));
+	int cid = cross[ei];
+	if (edge_flow[first[t]] > 0 && edge_flow[cid] > 0
+			&& edge_flow[first[pin]] > 0) {
+		adjust_flow(ei, -1);
+		adjust_flow(first[t], -1);
+		adjust_flow(cid, -1);
+		adjust_flow(first[pin], -1);
+	}
+}
+
+void vertex_cut_graph::cancel(int u) {
+	adjust_flow(first[inv(u)], -1);
+
+	// Follow the flow forward to a sink, cancelling it on the way. Any other
+	// vertex with flow coming in has flow going out, so this ends at a sink
+	// (possibly after cancelling a cycle along the way).
+	int x = outv(u);
+	while (!sinks.contains(x) || sinks.get(x) == 0) {
+		int i = first[x];
+		while (i < first[x + 1] && edge_flow[i] <= 0) ++i;
+		if (i == first[x + 1]) break;
+		adjust_flow(i, -1);
+		x = head[i];
+	}
+	if (sinks.contains(x)) {
+		record_terminal(sinks, x);
+		sinks.set(x, sinks.get(x) - 1);
+	}
+
+	// Likewise backward to a source.
+	x = inv(u);
+	while (!sources.contains(x) || sources.get(x) == 0) {
+		int i = first[x];
+		while (i < first[x + 1] && edge_flow[i] >= 0) ++i;
+		if (i == first[x + 1]) break;
+		adjust_flow(i, 1);
+		x = head[i];
+	}
+	if (sources.contains(x)) {
+		record_terminal(sources, x);
+		sources.set(x, sources.get(x) - 1);
+	}
+	--flow;
+}
+
+void vertex_cut_graph::augment() {
+	if (sources.empty() || sinks.empty()) return;
+	for (;;) {
+		// Label the distances from the sources in the residual graph, up to
+		// the nearest sinks.
+		int qhead = 0, qtail = 0;
+		bool reached = false;
+		level.reset_all();
+		for (int s : sources.members()) {
+			level.set(s, 0);
+			current[s] = first[s];
+			queue[qtail++] = s;
+		}
+		while (qhead < qtail) {
+			int u = queue[qhead++];
+			if (sinks.contains(u)) {
+				reached = true;
+				continue;
+			}
+			for (int i = first[u]; i < first[u + 1]; ++i) {
+				int v = head[i];
+				if (edge_flow[i] >= edge_cap[i]) continue;
+				if (state[lift(v)] == vertex_state::inactive) continue;
+				if (level.get(v) >= 0) continue;
+				level.set(v, level.get(u) + 1);
+				current[v] = first[v];
+				queue[qtail++] = v;
+			}
+		}
+		if (!reached) return;
+
+		// Find a blocking flow along the labels, by depth first search from
+		// every source.
+		const std::vector<int> &from = sources.members();
+		for (size_t k = 0; k < from.size(); ++k) {
+			int s = from[k], u = s;
+			path.clear();
+			for (;;) {
+				if (u != s && sinks.contains(u)) {
+					for (size_t j = path.size(); j-- > 0; ) {
+						adjust_flow(path[j], 1);
+						cancel_cycle(path[j]);
+					}
+					record_terminal(sources, s);
+					sources.set(s, sources.get(s) + 1);
+					record_terminal(sinks, u);
+					sinks.set(u, sinks.get(u) + 1);
+					++flow;
+					path.clear();
+					u = s;
+					continue;
+				}
+
+				// Advance along an admissible edge, or retreat.
+				int32_t &i = current[u];
+				while (i < first[u + 1] && (edge_flow[i] >= edge_cap[i]
+						|| level.get(head[i]) != level.get(u) + 1))
+					++i;
+				if (i < first[u + 1]) {
+					path.push_back(i);
+					u = head[i];
+				} else if (u == s) {
+					break;
+				} else {
+					level.set(u, -1);
+					u = head[rev[path.back()]];
+					path.pop_back();
+					++current[u];
+				}
+			}
+		}
+	}
+}
+
+void vertex_cut_graph::add_edge(std::vector<int32_t> &next, int u, int v,
+		int c, int cid) {
+	int32_t ei = next[u]++, ri = next[v]++;
+	head[ei] = v;
+	rev[ei] = ri;
+	cross[ei] = cid;
+	edge_cap[ei] = c;
+	head[ri] = u;
+	rev[ri] = ei;
+	cross[ri] = -1;
+	edge_cap[ri] = 0;
+}
+
+void vertex_cut_graph::adjust_flow(int ei, int c) {
+	record(change_type::flow, 0, ei, c);
+	change_flow(ei, c);
+}
+
+void vertex_cut_graph::change_flow(int ei, int c) {
+	edge_flow[ei] += c;
+	edge_flow[rev[ei]] -= c;
+
+	// At most one of the two carries flow.
+	for (int i : {ei, (int)rev[ei]}) {
+		bool positive = edge_flow[i] > 0;
+		if (positive && carrying_pos[i] < 0) {
+			carrying_pos[i] = (int32_t)carrying.size();
+			carrying.push_back(i);
+		} else if (!positive && carrying_pos[i] >= 0) {
+			carrying[carrying_pos[i]] = carrying.back();
+			carrying_pos[carrying.back()] = carrying_pos[i];
+			carrying.pop_back();
+			carrying_pos[i] = -1;
+		}
+	}
+}
+
+int vertex_cut_graph::checkpoint() {
+	frames.push_back(checkpoint_frame{log.size(), flow});
+	return (int)frames.size() - 1;
+}
+
+void vertex_cut_graph::rollback(int id) {
+	const checkpoint_frame frame = frames[id];
+	frames.resize(id);
+
+	// Revert the modifications in reverse order.
+	while (log.size() > frame.log_size) {
+		const change ch = log.back();
+		log.pop_back();
+		switch (ch.type) {
+			case change_type::flow: {
+				change_flow(ch.i, -ch.value);
+				break;
+			}
+			case change_type::capacity: {
+				edge_cap[first[inv(ch.u)]] = ch.value;
+				break;
+			}
+			case change_type::state: {
+				state[ch.u] = (vertex_state)ch.value;
+				break;
+			}
+			case change_type::source:
+			case change_type::sink: {
+				terminal_set &T
+					= ch.type == change_type::source ? sources : sinks;
+				if (ch.i) T.set(ch.u, ch.value);
+				else T.erase(ch.u);
+				break;
+			}
+		}
+	}
+	flow = frame.flow;
+}
+
+void vertex_cut_graph::changed_since(int id, std::vector<int> &out) const {
+	for (size_t i = frames[id].log_size; i < log.size(); ++i) {
+		const change &ch = log[i];
+		if (ch.type == change_type::state) {
+			out.push_back(ch.u);
+		} else if (ch.type == change_type::flow) {
+			// Only the passthrough edge (or its residual) matters.
+			int u = lift(head[ch.i]);
+			if (ch.i == first[inv(u)] || ch.i == first[outv(u)])
+				out.push_back(u);
+		}
+	}
+}
+
+void vertex_cut_graph::record(change_type type, int u, int i, int value) {
+	if (!frames.empty())
+		log.push_back(change{type, u, i, value});
 }
 
-void vertex_cut_graph::adjust_flow(int u, int ei, int c) {
-	magnitude += -abs(graph[u][ei].flow) + abs(graph[u][ei].flow + c);
-	graph[u][ei].flow += c;
-	graph[graph[u][ei].v][graph[u][ei].rev].flow -= c;
+void vertex_cut_graph::record_terminal(const terminal_set &T, int u) {
+	if (frames.empty() || (&T != &sources && &T != &sinks)) return;
+	record(&T == &sources ? change_type::source : change_type::sink, u,
+		T.contains(u), T.contains(u) ? T.get(u) : 0);
 }
 
 }
@@ -1,7 +1,8 @@
 #ifndef VERTEX_CUT_GRAPH_H
 #define VERTEX_CUT_GRAPH_H
 
-#include <unordered_map>
+#include <cstdint>
+#include <utility>
 #include <vector>
 
 #include "./matrix.h"
@@ -12,32 +13,91 @@ namespace mp {
 // In the vertex cut graph, vertices exist in four states:
 enum class vertex_state { inactive, active, source, sink };
 
-struct internal_edge {
-	const int v;		// Index of the endpoint.
-	const int rev;		// Residual edge index.
-	int flow = 0, cap;	// Edge flow and capacity.
-	const int crossid;	// Id of the crossing edge, if it exists.
-	internal_edge(int v, int rev, int cap, int crossid = -1) :
-		v(v), rev(rev), cap(cap), crossid(crossid) { }
-};
-
 inline int inv(int i) { return 2*i; }
 inline int outv(int i) { return 2*i+1; }
 inline int lift(int u) { return u/2; }
 
+// A set of terminals (internal vertices) of the vertex cut graph, with a
+// count for each. Stored densely, membership is marked by the current epoch
+// so the set can be cleared in constant time. The members are also kept in
+// a list (in no particular order) to iterate over them.
+class terminal_set {
+public:
+	terminal_set(int V) { assign(V); }
+
+	// Make this the empty set on [0, V), reusing the memory held.
+	void assign(int V) {
+		count.assign(V, 0);
+		pos.assign(V, 0);
+		stamp.assign(V, 0);
+		list.clear();
+		list.reserve(V);
+		epoch = 1;
+	}
+
+	bool empty() const { return list.empty(); }
+	bool contains(int u) const { return stamp[u] == epoch; }
+	int get(int u) const { return count[u]; }
+	const std::vector<int> &members() const { return list; }
+
+	void set(int u, int c) {
+		if (!contains(u)) {
+			stamp[u] = epoch;
+			pos[u] = (int)list.size();
+			list.push_back(u);
+		}
+		count[u] = c;
+	}
+
+	void erase(int u) {
+		if (!contains(u)) return;
+		stamp[u] = epoch - 1;
+		list[pos[u]] = list.back();
+		pos[list.back()] = pos[u];
+		list.pop_back();
+	}
+
+	void clear() {
+		++epoch;
+		list.clear();
+	}
+
+private:
+	std::vector<int> count, pos, list;
+	std::vector<unsigned> stamp;
+	unsigned epoch = 1;
+};
+
+// How batches of activity changes were processed: by updating the flow for
+// each change in turn, or by recomputing a maximum flow afterwards.
+struct flow_stats {
+	long long incremental = 0, recomputed = 0;
+};
+
 // A dynamically maintaned graph for computing minimal vertex cuts between two
 // sets of vertices.
 class vertex_cut_graph {
 public:
-	const int V;
-	int flow = 0, magnitude = 0;
+	int V = 0;
+	int flow = 0;
 
 	vertex_cut_graph(const matrix &m);
 
+	// Rebuild the graph for m, with every vertex active and no flow, reusing
+	// the memory held.
+	void reset(const matrix &m);
+
 	// Toggle vertex activity.
 	void set_activity(int u, vertex_state s);
 	vertex_state get_activity(int u) const;
 
+	// Apply a batch of activity changes. Large batches of deactivations are
+	// processed by cancelling the flow through the deactivated vertices and
+	// restoring a maximum flow from what is left, instead of rerouting
+	// around each vertex separately.
+	void set_activities(const std::vector<std::pair<int, vertex_state>> &batch);
+	const flow_stats &get_stats() const;
+
 	// Retrieve maximal vertex cut.
 	int get_minimum_vertex_cut() const;
 
@@ -45,31 +105,107 @@ public:
 	// not part of a flow path.
 	bool is_free(int u) const;
 
+	// Every modification made after a checkpoint is logged, so that rollback
+	// can restore the exact state at that checkpoint (and drop all later
+	// checkpoints) without searching for any augmenting paths.
+	int checkpoint();
+	void rollback(int id);
+
+	// Append the vertices of which the state or the flow passing through
+	// changed since checkpoint id, i.e. those that may have become (non-)free.
+	// Vertices may be appended more than once.
+	void changed_since(int id, std::vector<int> &out) const;
+
 private:
 	// Current state of each vertex, in external terms.
 	std::vector<vertex_state> state;
 
-	// The graph.
-	std::vector<std::vector<internal_edge>> graph;
+	// The graph, in compressed sparse row format: the edges leaving internal
+	// vertex u are first[u], ..., first[u + 1] - 1. For every edge we store
+	// its endpoint, the index of its residual edge, the index of its
+	// crossing edge (if it exists, -1 otherwise), and its flow and capacity.
+	// The first edge of inv(u) is the passthrough edge of u, the first edge
+	// of outv(u) is its residual.
+	std::vector<int32_t> first, head, rev, cross;
+	std::vector<int32_t> edge_flow, edge_cap;
+
+	// The edges carrying (positive) flow, and the index of each edge in this
+	// list (-1 if it carries none). Of an edge and its residual at most one
+	// is in the list.
+	std::vector<int32_t> carrying, carrying_pos;
 	
-	// Current sources/sinks (including out/in flow)
-	std::unordered_map<int, int> sources, sinks;
+	// Current sources/sinks (including out/in flow), and a single target
+	// used when rerouting flow around a vertex.
+	terminal_set sources, sinks, reroute;
 
 	// Internally used rvectors (for finding augmenting paths).
 	// Give parent vertex and parent edge (index).
 	mp::rvector<int> par, pari;
 
+	// Queue for the breadth first searches. Every vertex is visited at most
+	// once per search, so it never holds more than V vertices.
+	std::vector<int> queue;
+
+	// Distance labels and current edges for Dinic's algorithm, and the path
+	// it is extending.
+	mp::rvector<int> level;
+	std::vector<int32_t> current, path;
+
+	flow_stats stats;
+
+	// Log of modifications since the first checkpoint. For flow changes i is
+	// the edge and value is the change in flow, otherwise value is the old
+	// capacity/state/count of vertex u, with i signalling whether u was a
+	// source/sink at all.
+	enum class change_type { flow, capacity, state, source, sink };
+	struct change {
+		change_type type;
+		int u, i, value;
+	};
+	std::vector<change> log;
+
+	// Log size and counters at each checkpoint.
+	struct checkpoint_frame {
+		size_t log_size;
+		int flow;
+	};
+	std::vector<checkpoint_frame> frames;
+
+	// Log a modification, if there is a checkpoint to roll back to.
+	void record(change_type type, int u, int i, int value);
+
+	// Log the count of u in T before changing it, if T is sources/sinks.
+	void record_terminal(const terminal_set &T, int u);
+
 	// Flow manipulation. The coefficient c (1/-1) signals whether we are
 	// adding or removing flow. Pushes/pulls a single augmenting path.
-	int push(int s, std::unordered_map<int, int> &T, int c);
-	int pull(int t, std::unordered_map<int, int> &S, int c);
+	int push(int s, terminal_set &T, int c);
+	int pull(int t, terminal_set &S, int c);
+
+	// Cancel the unit of flow through (active) vertex u, along the flow
+	// path from a source to a sink.
+	void cancel(int u);
+
+	// Augment the current flow to a maximum flow with Dinic's algorithm.
+	void augment();
+
+	// After adding flow through edge ei, cancel the flow cycle it may have
+	// closed (see push).
+	void cancel_cycle(int ei);
+
+	// Zero stray flow when there is no flow left (see set_activity).
+	void clear_stray_flow();
 
-	// Add an edge - internal indexation! If this is an external edge then
-	// cid should be the index of the crossing/reverse edge.
-	void add_edge(int u, int v, int cap, int cid = -1);
+	// Add an edge - internal indexation! The edge and its residual are put
+	// at position next[u] and next[v] respectively. If this is an external
+	// edge then cid should be the index of the crossing/reverse edge.
+	void add_edge(std::vector<int32_t> &next, int u, int v, int c,
+		int cid = -1);
 
-	// Adjust the flow through an edge. Uses internal ids.
-	void adjust_flow(int u, int ei, int c);
+	// Adjust the flow through an edge. change_flow does the same without
+	// logging.
+	void adjust_flow(int ei, int c);
+	void change_flow(int ei, int c);
 };
 
 }
@@ -0,0 +1,257 @@
+#include "./batch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "./problem.h"
+#include "./work-queue.h"
+#include "../io/output.h"
+#include "../partitioner/partition-util.h"
+
+namespace mp {
+
+namespace {
+
+const std::vector<std::string> MATRIX_EXTENSIONS = {
+	".tar.gz", ".mtx.gz", ".mtx", ".mpb"
+};
+
+bool ends_with(const std::string &s, const std::string &suffix) {
+	return s.size() >= suffix.size()
+		&& s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// The file name of path, without any of the matrix extensions.
+std::string matrix_name(const std::string &path) {
+	size_t slash = path.find_last_of('/');
+	std::string name = slash == std::string::npos ? path
+		: path.substr(slash + 1);
+	for (const std::string &ext : MATRIX_EXTENSIONS) {
+		if (ends_with(name, ext) && name.size() > ext.size())
+			return name.substr(0, name.size() - ext.size());
+	}
+	return name;
+}
+
+void find_matrices(const std::string &dir, std::vector<std::string> &paths) {
+	DIR *d = opendir(dir.c_str());
+	if (d == nullptr) return;
+	while (dirent *e = readdir(d)) {
+		std::string name = e->d_name;
+		if (name == "." || name == "..") continue;
+		std::string path = dir + "/" + name;
+		struct stat st;
+		if (stat(path.c_str(), &st) != 0) continue;
+		if (S_ISDIR(st.st_mode)) {
+			find_matrices(path, paths);
+		} else if (S_ISREG(st.st_mode)) {
+			for (const std::string &ext : MATRIX_EXTENSIONS) {
+				if (ends_with(name, ext)) {
+					paths.push_back(path);
+					break;
+				}
+			}
+		}
+	}
+	closedir(d);
+}
+
+// The outcome for a single job.
+struct batch_result {
+	std::string state = "unreadable";
+	int R = 0, C = 0, NZ = 0;
+	int volume = -1;
+	double load = 0.0, solve = 0.0;
+	long long nodes = 0;
+};
+
+// A job moving through the pipeline. p is empty if the matrix could not be
+// loaded.
+struct batch_item {
+	size_t index = 0;
+	std::unique_ptr<problem> p;
+	std::vector<status> row, col;
+};
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - start).count();
+}
+
+void print_summary(std::ostream &summary, const std::vector<batch_job> &jobs,
+		const std::vector<batch_result> &results, double wall) {
+	size_t width = 6;
+	for (const batch_job &job : jobs)
+		width = std::max(width, job.name.size());
+
+	summary << std::left << std::setw(width) << "matrix" << std::right
+		<< std::setw(9) << "rows" << std::setw(9) << "cols"
+		<< std::setw(11) << "nonzeros" << std::setw(7) << "eps"
+		<< std::setw(7) << "tl" << std::setw(8) << "volume"
+		<< std::setw(11) << "result" << std::setw(10) << "load(s)"
+		<< std::setw(10) << "solve(s)" << std::setw(14) << "nodes" << '\n';
+	int optimal = 0;
+	for (size_t i = 0; i < jobs.size(); ++i) {
+		const batch_result &r = results[i];
+		summary << std::left << std::setw(width) << jobs[i].name << std::right
+			<< std::setw(9) << r.R << std::setw(9) << r.C
+			<< std::setw(11) << r.NZ << std::setw(7) << jobs[i].eps
+			<< std::setw(7) << jobs[i].tl << std::setw(8);
+		if (r.volume >= 0) summary << r.volume;
+		else summary << '-';
+		summary << std::setw(11) << r.state << std::fixed
+			<< std::setprecision(2) << std::setw(10) << r.load
+			<< std::setw(10) << r.solve << std::setw(14) << r.nodes << '\n';
+		summary.unsetf(std::ios::fixed);
+		summary << std::setprecision(6);
+		if (r.state == "optimal") ++optimal;
+	}
+	summary << optimal << " of " << jobs.size()
+		<< " matrices solved to optimality in " << std::fixed
+		<< std::setprecision(2) << wall << " seconds." << std::endl;
+	summary.unsetf(std::ios::fixed);
+	summary << std::setprecision(6);
+}
+
+}
+
+bool read_batch_jobs(const std::string &path, float eps, long long tl,
+		std::vector<batch_job> &jobs) {
+	struct stat st;
+	if (stat(path.c_str(), &st) != 0)
+		return false;
+
+	if (S_ISDIR(st.st_mode)) {
+		std::vector<std::string> paths;
+		find_matrices(path, paths);
+		std::sort(paths.begin(), paths.end());
+		for (const std::string &p : paths)
+			jobs.push_back(batch_job{p, matrix_name(p), eps, tl});
+		return true;
+	}
+
+	std::ifstream list(path);
+	if (!list) return false;
+	std::string line;
+	while (std::getline(list, line)) {
+		std::istringstream iss(line);
+		batch_job job{"", "", eps, tl};
+		if (!(iss >> job.path) || job.path[0] == '#') continue;
+		if (iss >> job.eps) iss >> job.tl;
+		job.name = matrix_name(job.path);
+		jobs.push_back(job);
+	}
+	return true;
+}
+
+void run_batch(const std::vector<batch_job> &jobs, const batch_options &opt,
+		std::ostream &summary) {
+	auto start = std::chrono::steady_clock::now();
+	int parallel = std::max(1, opt.parallel);
+	std::vector<batch_result> results(jobs.size());
+
+	// Loaded matrices wait for a solver, solved ones for the writer. Each
+	// stage runs at most parallel matrices ahead of the next.
+	work_queue<batch_item> loaded(parallel), solved(parallel);
+
+	std::vector<std::thread> solvers;
+	for (int t = 0; t < parallel; ++t) {
+		solvers.emplace_back([&]() {
+			batch_item item;
+			while (loaded.pop(item)) {
+				if (item.p) {
+					const batch_job &job = jobs[item.index];
+					batch_result &r = results[item.index];
+					{
+						std::lock_guard<std::mutex> guard(debug_lock());
+						std::cerr << "Partitioning " << job.name << " ("
+							<< r.R << 'x' << r.C << ", " << r.NZ
+							<< " nonzeros) with eps=" << job.eps << ", TL="
+							<< job.tl << std::endl;
+					}
+					auto solve_start = std::chrono::steady_clock::now();
+					std::unique_ptr<partitioner> part = opt.make_partitioner();
+					bool ok = part->partition(item.p->m, item.row, item.col,
+						job.eps, job.tl);
+					r.solve = seconds_since(solve_start);
+					r.nodes = part->nodes();
+					if (!item.row.empty()
+							&& item.row[0] != status::unassigned) {
+						r.volume = (int)(std::count(item.row.begin(),
+							item.row.end(), status::cut) + std::count(
+							item.col.begin(), item.col.end(), status::cut));
+						r.state = ok ? "optimal" : "timeout";
+					} else {
+						item.row.clear();
+						r.state = "failed";
+					}
+				}
+				solved.push(std::move(item));
+			}
+		});
+	}
+
+	std::thread writer([&]() {
+		batch_item item;
+		while (solved.pop(item)) {
+			if (item.p && !item.row.empty() && !opt.outdir.empty()) {
+				std::string path = opt.outdir + "/" + jobs[item.index].name
+					+ ".mtx";
+				std::ofstream out(path);
+				if (out)
+					print_partitioned_mm(out, item.p->m, item.p->ids.data(),
+						item.p->R, item.p->C, item.row, item.col);
+				if (!out) {
+					std::lock_guard<std::mutex> guard(debug_lock());
+					std::cerr << "Could not write " << path << std::endl;
+				}
+			}
+			// Release the matrix before waiting for the next one.
+			item = batch_item();
+		}
+	});
+
+	// Read and compress the matrices in order, on this thread.
+	for (size_t i = 0; i < jobs.size(); ++i) {
+		batch_item item;
+		item.index = i;
+		auto load_start = std::chrono::steady_clock::now();
+		int fd = open(jobs[i].path.c_str(), O_RDONLY);
+		std::unique_ptr<problem> p(new problem());
+		if (fd >= 0 && load_problem(fd, *p) && p->m.NZ > 0) {
+			batch_result &r = results[i];
+			r.R = p->m.R;
+			r.C = p->m.C;
+			r.NZ = p->m.NZ;
+			r.load = seconds_since(load_start);
+			item.p = std::move(p);
+		} else {
+			std::lock_guard<std::mutex> guard(debug_lock());
+			std::cerr << "Could not read a matrix from " << jobs[i].path
+				<< std::endl;
+		}
+		if (fd >= 0) close(fd);
+		loaded.push(std::move(item));
+	}
+
+	loaded.close();
+	for (std::thread &t : solvers) t.join();
+	solved.close();
+	writer.join();
+
+	print_summary(summary, jobs, results, seconds_since(start));
+}
+
+}
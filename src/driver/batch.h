@@ -0,0 +1,49 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "../partitioner/partitioner.h"
+
+namespace mp {
+
+// A matrix to partition in batch mode, with its own eps and time limit.
+struct batch_job {
+	std::string path, name;
+	float eps;
+	long long tl;
+};
+
+// Collect the jobs in path. A directory is searched recursively for matrices
+// (.mtx, .mtx.gz, .tar.gz and .mpb files), which get the given eps and time
+// limit. Any other file is read as a list with one matrix per line:
+//   path [eps [tl]]
+// Empty lines and lines starting with '#' are skipped. Returns false if path
+// could not be read.
+bool read_batch_jobs(const std::string &path, float eps, long long tl,
+	std::vector<batch_job> &jobs);
+
+struct batch_options {
+	// Number of matrices partitioned at the same time.
+	int parallel = 1;
+
+	// If not empty, the partitioned matrices are written to outdir/NAME.mtx.
+	std::string outdir;
+
+	// Creates the partitioner for a single matrix.
+	std::function<std::unique_ptr<partitioner>()> make_partitioner;
+};
+
+// Partition all jobs. Matrices are read and compressed ahead by one thread
+// while others are partitioned, and results are written by another. Prints a
+// summary table, in the order of the jobs, to summary.
+void run_batch(const std::vector<batch_job> &jobs, const batch_options &opt,
+	std::ostream &summary);
+
+}
+
+#endif
@@ -0,0 +1,227 @@
+#include "./cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <thread>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../io/output.h"
+
+namespace mp {
+
+// Increased whenever the format of the entries changes.
+constexpr int CACHE_VERSION = 1;
+
+// Color refinement stops after this many rounds, even if not yet stable.
+constexpr int MAX_ROUNDS = 32;
+
+namespace {
+
+inline uint64_t mix(uint64_t x) {
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+size_t count_distinct(std::vector<uint64_t> values) {
+	std::sort(values.begin(), values.end());
+	return std::unique(values.begin(), values.end()) - values.begin();
+}
+
+int count_cut(const std::vector<status> &s) {
+	return (int)std::count(s.begin(), s.end(), status::cut);
+}
+
+}
+
+canonical_form::canonical_form(const matrix &m) : label(m.R + m.C) {
+	int n = m.R + m.C;
+
+	// Refine colors, starting from the side and degree, until no class
+	// splits any more.
+	std::vector<uint64_t> color(n), next(n);
+	for (int rc = 0; rc < n; ++rc)
+		color[rc] = mix(((uint64_t)(rc < m.R ? 1 : 2) << 32) + m[rc].size());
+	size_t classes = count_distinct(color);
+	for (int round = 0; round < MAX_ROUNDS && classes < (size_t)n; ++round) {
+		for (int rc = 0; rc < n; ++rc) {
+			uint64_t sum = 0;
+			for (const entry &e : m[rc])
+				sum += mix(color[e.rc]);
+			next[rc] = mix(color[rc] ^ mix(sum));
+		}
+		size_t refined = count_distinct(next);
+		if (refined == classes) break;
+		color.swap(next);
+		classes = refined;
+	}
+
+	// Label rows and columns by color, ties in the original order.
+	std::vector<int> order(n);
+	std::iota(order.begin(), order.end(), 0);
+	auto by_color = [&color](int l, int r) {
+		return color[l] < color[r] || (color[l] == color[r] && l < r);
+	};
+	std::sort(order.begin(), order.begin() + m.R, by_color);
+	std::sort(order.begin() + m.R, order.end(), by_color);
+	for (int i = 0; i < n; ++i)
+		label[order[i]] = i;
+
+	// Hash the relabeled matrix, row by row.
+	hash[0] = mix(((uint64_t)m.R << 32) + m.C);
+	hash[1] = mix(hash[0] ^ (uint64_t)m.NZ);
+	std::vector<int> cols;
+	for (int i = 0; i < m.R; ++i) {
+		int r = order[i];
+		cols.clear();
+		for (const entry &e : m[r])
+			cols.push_back(label[e.rc]);
+		std::sort(cols.begin(), cols.end());
+		hash[0] = mix(hash[0] ^ cols.size());
+		hash[1] = mix(hash[1] + cols.size());
+		for (int c : cols) {
+			hash[0] = mix(hash[0] ^ (uint64_t)c);
+			hash[1] = mix(hash[1] + (uint64_t)c);
+		}
+	}
+}
+
+result_cache::result_cache(const std::string &dir, const matrix &_m,
+		float epsilon) : m(_m), max_size(max_partition_size(_m.NZ, epsilon)),
+		form(_m) {
+	char name[64];
+	snprintf(name, sizeof(name), "%016llx%016llx-%d.mpc",
+		(unsigned long long)form.hash[0], (unsigned long long)form.hash[1],
+		max_size);
+	path = dir + "/" + name;
+}
+
+bool result_cache::valid(const std::vector<status> &s) const {
+	if (s.size() != (size_t)(m.R + m.C))
+		return false;
+	for (status st : s) {
+		if (st != status::red && st != status::blue && st != status::cut)
+			return false;
+	}
+
+	// Every nonzero must fit on a side, and neither side may grow too big.
+	int size[2] = {0, 0};
+	for (int r = 0; r < m.R; ++r) {
+		for (const entry &e : m[r]) {
+			status rs = s[r], cs = s[e.rc];
+			if ((rs == status::red && cs == status::blue)
+					|| (rs == status::blue && cs == status::red))
+				return false;
+			if (rs == status::red || cs == status::red) ++size[RED];
+			else if (rs == status::blue || cs == status::blue) ++size[BLUE];
+		}
+	}
+	return size[RED] <= max_size && size[BLUE] <= max_size
+		&& m.NZ <= 2 * max_size;
+}
+
+bool result_cache::load(std::vector<status> &s, int &lb) const {
+	std::ifstream in(path);
+	if (!in) return false;
+
+	std::string magic, stored;
+	int version, R, C, NZ, volume;
+	if (!(in >> magic >> version >> R >> C >> NZ >> lb >> volume >> stored)
+			|| magic != "mp-cache" || version != CACHE_VERSION
+			|| R != m.R || C != m.C || NZ != m.NZ
+			|| stored.size() != (size_t)(m.R + m.C))
+		return false;
+
+	s.resize(m.R + m.C);
+	for (int rc = 0; rc < m.R + m.C; ++rc)
+		s[rc] = (status)(stored[form.label[rc]] - '0');
+	if (!valid(s) || count_cut(s) != volume) {
+		std::lock_guard<std::mutex> guard(debug_lock());
+		std::cerr << "Ignoring invalid cache entry " << path << std::endl;
+		s.clear();
+		return false;
+	}
+	lb = std::min(lb, volume);
+	return true;
+}
+
+void result_cache::store(const std::vector<status> &s, int lb) const {
+	std::vector<status> best = s;
+	int known_lb = 0;
+	std::vector<status> known;
+	if (load(known, known_lb)) {
+		if (count_cut(known) <= count_cut(s) && known_lb >= lb)
+			return;
+		if (count_cut(known) < count_cut(s))
+			best = known;
+		lb = std::max(lb, known_lb);
+	}
+
+	std::string stored(m.R + m.C, '0');
+	for (int rc = 0; rc < m.R + m.C; ++rc)
+		stored[form.label[rc]] = (char)('0' + best[rc]);
+
+	// Write to a temporary file first, so that concurrent readers (and
+	// writers) see either the old or the new entry.
+	size_t slash = path.find_last_of('/');
+	mkdir(path.substr(0, slash).c_str(), 0777);
+	std::ostringstream tmp;
+	tmp << path << ".tmp." << getpid() << '.'
+		<< std::hash<std::thread::id>()(std::this_thread::get_id());
+	{
+		std::ofstream out(tmp.str());
+		out << "mp-cache " << CACHE_VERSION << '\n' << m.R << ' ' << m.C
+			<< ' ' << m.NZ << ' ' << lb << ' ' << count_cut(best) << '\n'
+			<< stored << '\n';
+		if (out.flush() && rename(tmp.str().c_str(), path.c_str()) == 0)
+			return;
+	}
+	unlink(tmp.str().c_str());
+	std::lock_guard<std::mutex> guard(debug_lock());
+	std::cerr << "Could not write cache entry " << path << std::endl;
+}
+
+bool cached_partitioner::partition(const matrix &m, std::vector<status> &row,
+		std::vector<status> &col, float epsilon, long long tl) {
+	explored = 0;
+	proven = 0;
+	result_cache cache(dir, m, epsilon);
+	std::vector<status> s;
+	int lb = 0;
+	if (cache.load(s, lb)) {
+		int volume = count_cut(s);
+		std::lock_guard<std::mutex> guard(debug_lock());
+		if (lb >= volume) {
+			std::cerr << "Found partition of volume " << volume
+				<< " in cache." << std::endl;
+			row.assign(s.begin(), s.begin() + m.R);
+			col.assign(s.begin() + m.R, s.end());
+			proven = volume;
+			return true;
+		}
+		std::cerr << "Starting from cached partition of volume " << volume
+			<< " and lower bound " << lb << std::endl;
+		inner->warm_start(s, lb);
+	}
+
+	bool ok = inner->partition(m, row, col, epsilon, tl);
+	explored = inner->nodes();
+	proven = std::max(lb, inner->lower_bound());
+	if (!row.empty() && row[0] != status::unassigned) {
+		s = row;
+		s.insert(s.end(), col.begin(), col.end());
+		cache.store(s, proven);
+	}
+	return ok;
+}
+
+}
@@ -0,0 +1,83 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../datastructures/matrix.h"
+#include "../partitioner/partitioner.h"
+#include "../partitioner/partition-util.h"
+
+namespace mp {
+
+// A canonical labeling of the rows and columns of a (compressed) matrix, and
+// a hash of the matrix under it. The labeling is found by color refinement
+// on the bipartite graph of the matrix, with ties broken by the original
+// order. Matrices equal up to a permutation of the rows and columns get the
+// same hash unless the refinement leaves ties between rows/columns that are
+// not interchangeable; different matrices get different hashes (barring
+// collisions).
+struct canonical_form {
+	// label[rc] is the canonical row (or column, offset by R) of rc.
+	std::vector<int> label;
+	uint64_t hash[2];
+
+	explicit canonical_form(const matrix &m);
+};
+
+// Partitionings stored on disk in dir, one file per canonical matrix and
+// maximal part size (so per eps). Every entry holds the best partitioning
+// found and the best lower bound proven.
+class result_cache {
+  public:
+	result_cache(const std::string &dir, const matrix &m, float epsilon);
+
+	// Look the matrix up. Returns whether a valid entry was found, in which
+	// case s (rows, then columns) and lb are set.
+	bool load(std::vector<status> &s, int &lb) const;
+
+	// Store a partitioning and lower bound, unless the entry already holds
+	// something at least as good.
+	void store(const std::vector<status> &s, int lb) const;
+
+  private:
+	const matrix &m;
+	int max_size;
+	canonical_form form;
+	std::string path;
+
+	// Whether s is a valid partitioning of m.
+	bool valid(const std::vector<status> &s) const;
+};
+
+// Answers from a result cache in dir when it holds an optimal partitioning,
+// and otherwise runs the given partitioner, warm-started from the cache, and
+// stores the result.
+class cached_partitioner : public partitioner {
+  private:
+	std::string dir;
+	std::unique_ptr<partitioner> inner;
+	long long explored = 0;
+	int proven = 0;
+
+  public:
+	cached_partitioner(const std::string &_dir,
+		std::unique_ptr<partitioner> _inner)
+		: dir(_dir), inner(std::move(_inner)) { }
+
+	virtual bool partition(const matrix &m, std::vector<status> &row,
+		std::vector<status> &col, float epsilon, long long tl);
+
+	virtual long long nodes() const { return explored; }
+	virtual int lower_bound() const { return proven; }
+	virtual void warm_start(const std::vector<status> &s, int lb) {
+		inner->warm_start(s, lb);
+	}
+};
+
+}
+
+#endif
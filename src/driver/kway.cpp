@@ -0,0 +1,212 @@
+#include "./kway.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <thread>
+
+#include "./work-queue.h"
+#include "../io/output.h"
+#include "../partitioner/partition-util.h"
+
+namespace mp {
+
+namespace {
+
+// Nonzeros (in increasing order) still to be split over the parts
+// [first, first + parts).
+struct subproblem {
+	std::vector<int> nzs;
+	int first = 0, parts = 1;
+};
+
+// The eps for bisecting n nonzeros that end up in parts parts of at most limit
+// nonzeros each. Every level below gets the same share of the room left, and
+// the last level all of it.
+float level_epsilon(int n, int parts, int limit) {
+	int levels = 0;
+	while ((1 << levels) < parts) ++levels;
+	float eps;
+	if (levels == 1) {
+		eps = (limit + 0.5f) / ((n + 1) / 2) - 1.0f;
+		while (eps > 0.0f && max_partition_size(n, eps) > limit)
+			eps = std::nextafter(eps, 0.0f);
+	} else {
+		eps = std::pow((float)limit * parts / n, 1.0f / levels) - 1.0f;
+	}
+	return std::max(eps, 0.0f);
+}
+
+// Bisect the submatrix of m holding the nonzeros of s, and split them over
+// the halves. Returns false if no bisection was found.
+bool bisect(const matrix &m, const std::vector<int> &rows,
+		const std::vector<int> &cols, const subproblem &s, int limit,
+		long long tl, partitioner &part, subproblem halves[2],
+		bool &optimal) {
+	int n = (int)s.nzs.size();
+
+	// The nonzeros are in order, so by row.
+	std::vector<int> row_ptr(m.R + 1, 0), col_idx(n);
+	for (int j = 0; j < n; ++j) {
+		++row_ptr[rows[s.nzs[j]] + 1];
+		col_idx[j] = cols[s.nzs[j]];
+	}
+	for (int r = 0; r < m.R; ++r)
+		row_ptr[r + 1] += row_ptr[r];
+	std::vector<int> ids;
+	matrix sub(m.R, m.C, row_ptr.data(), col_idx.data(), ids);
+	std::vector<int> where(m.R + m.C, -1);
+	for (size_t i = 0; i < ids.size(); ++i)
+		where[ids[i]] = (int)i;
+
+	float eps = level_epsilon(n, s.parts, limit);
+	std::vector<status> row, col;
+	optimal = part.partition(sub, row, col, eps, tl);
+	if (row.empty() || row[0] == status::unassigned)
+		return false;
+
+	// Nonzeros with a row or column on a side go to that side. Those with
+	// both cut may go anywhere, and even out the sides.
+	std::vector<int> side(n, -1);
+	int size[2] = {0, 0};
+	for (int j = 0; j < n; ++j) {
+		status rs = row[where[rows[s.nzs[j]]]];
+		status cs = col[where[m.R + cols[s.nzs[j]]] - sub.R];
+		if (rs == status::red || cs == status::red) side[j] = RED;
+		else if (rs == status::blue || cs == status::blue) side[j] = BLUE;
+		else continue;
+		++size[side[j]];
+	}
+	int free_red = std::max(0, (n + 1) / 2 - size[RED]);
+	for (int j = 0; j < n; ++j) {
+		if (side[j] < 0) side[j] = free_red-- > 0 ? RED : BLUE;
+		halves[side[j]].nzs.push_back(s.nzs[j]);
+	}
+	for (int h = 0; h < 2; ++h) {
+		halves[h].parts = s.parts / 2;
+		halves[h].first = s.first + h * halves[h].parts;
+	}
+
+	std::lock_guard<std::mutex> guard(debug_lock());
+	std::cerr << "Bisected " << n << " nonzeros for parts " << s.first
+		<< " to " << s.first + s.parts - 1 << " with eps=" << eps
+		<< ", volume " << std::count(row.begin(), row.end(), status::cut)
+			+ std::count(col.begin(), col.end(), status::cut)
+		<< (optimal ? "" : " (not optimal)") << std::endl;
+	return true;
+}
+
+}
+
+bool partition_kway(const matrix &m, float epsilon, long long tl,
+		const kway_options &opt, kway_result &result) {
+	result = kway_result();
+	if (opt.parts < 1 || (opt.parts & (opt.parts - 1)) != 0) {
+		std::lock_guard<std::mutex> guard(debug_lock());
+		std::cerr << "The number of parts must be a power of two."
+			<< std::endl;
+		return false;
+	}
+	int limit = max_partition_size(m.NZ, epsilon, opt.parts);
+	if ((long long)limit * opt.parts < m.NZ) {
+		std::lock_guard<std::mutex> guard(debug_lock());
+		std::cerr << "No valid partitioning exists with this value of epsilon."
+			<< std::endl;
+		return false;
+	}
+
+	// The row and column of every nonzero.
+	std::vector<int> rows(m.NZ), cols(m.NZ);
+	for (int r = 0, i = 0; r < m.R; ++r) {
+		for (const entry &e : m[r]) {
+			rows[i] = r;
+			cols[i++] = e.rc - m.R;
+		}
+	}
+
+	result.part.assign(m.NZ, 0);
+	result.optimal = true;
+	work_queue<subproblem> todo(opt.parts);
+	std::mutex lock;
+	int pending = 0;
+	bool failed = false;
+
+	// Queue a subproblem, or assign its nonzeros if it needs no splitting.
+	auto add = [&](subproblem s) {
+		if (s.parts == 1 || s.nzs.empty()) {
+			for (int i : s.nzs)
+				result.part[i] = s.first;
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			++pending;
+		}
+		todo.push(std::move(s));
+	};
+
+	subproblem all;
+	all.nzs.resize(m.NZ);
+	std::iota(all.nzs.begin(), all.nzs.end(), 0);
+	all.parts = opt.parts;
+	add(std::move(all));
+	if (pending == 0)
+		todo.close();
+
+	std::vector<std::thread> workers;
+	int parallel = std::max(1, std::min(opt.parallel, opt.parts / 2));
+	for (int t = 0; t < parallel; ++t) {
+		workers.emplace_back([&]() {
+			std::unique_ptr<partitioner> part = opt.make_partitioner();
+			subproblem s;
+			while (todo.pop(s)) {
+				subproblem halves[2];
+				bool optimal = false;
+				bool ok = bisect(m, rows, cols, s, limit, tl, *part, halves,
+					optimal);
+				if (ok) {
+					add(std::move(halves[0]));
+					add(std::move(halves[1]));
+				}
+				std::lock_guard<std::mutex> guard(lock);
+				failed |= !ok;
+				result.optimal &= optimal;
+				result.nodes += part->nodes();
+				if (--pending == 0)
+					todo.close();
+			}
+		});
+	}
+	for (std::thread &t : workers) t.join();
+
+	if (failed)
+		return false;
+	result.volume = kway_volume(m, result.part);
+	return true;
+}
+
+int kway_volume(const matrix &m, const std::vector<int> &part) {
+	const int *first = m.offsets();
+	int parts = part.empty() ? 0 : *std::max_element(part.begin(), part.end())
+		+ 1;
+	std::vector<int> seen(parts, -1);
+	int volume = 0;
+	for (int rc = 0; rc < m.R + m.C; ++rc) {
+		int lambda = 0;
+		for (const entry &e : m[rc]) {
+			// Rows hold their own nonzeros in order, columns point into them.
+			int i = rc < m.R ? first[rc] + (int)(&e - m[rc].begin())
+				: first[e.rc] + e.index;
+			if (seen[part[i]] != rc) {
+				seen[part[i]] = rc;
+				++lambda;
+			}
+		}
+		volume += std::max(lambda - 1, 0);
+	}
+	return volume;
+}
+
+}
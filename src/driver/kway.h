@@ -0,0 +1,55 @@
+#ifndef KWAY_H
+#define KWAY_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "../datastructures/matrix.h"
+#include "../partitioner/partitioner.h"
+
+namespace mp {
+
+struct kway_options {
+	// Number of parts, a power of two.
+	int parts = 2;
+
+	// Number of bisections solved at the same time.
+	int parallel = 1;
+
+	// Creates the partitioner used for the bisections.
+	std::function<std::unique_ptr<partitioner>()> make_partitioner;
+};
+
+struct kway_result {
+	// part[i] is the part of nonzero i of m, numbering the nonzeros row by
+	// row (as in m.data()).
+	std::vector<int> part;
+
+	// The (lambda - 1) communication volume.
+	int volume = -1;
+
+	// Whether every bisection was solved to optimality.
+	bool optimal = false;
+
+	// Total number of branch and bound nodes over all bisections.
+	long long nodes = 0;
+};
+
+// Partition the nonzeros of m into opt.parts parts of at most
+// max_partition_size(m.NZ, epsilon, opt.parts) nonzeros each, by bisecting
+// recursively. The eps of every bisection is chosen from the room left for
+// the parts below it, so the final imbalance holds whenever every bisection
+// succeeds. Bisections of different submatrices are solved in parallel, each
+// with time limit tl. Returns false if some bisection failed.
+bool partition_kway(const matrix &m, float epsilon, long long tl,
+	const kway_options &opt, kway_result &result);
+
+// The (lambda - 1) volume of a partitioning of the nonzeros of m (numbered
+// as above): the number of parts every row and column has nonzeros in, minus
+// one, summed.
+int kway_volume(const matrix &m, const std::vector<int> &part);
+
+}
+
+#endif
@@ -0,0 +1,42 @@
+#include "./problem.h"
+
+#include <memory>
+
+#include "../datastructures/matrix-util.h"
+#include "../io/binary.h"
+#include "../io/input.h"
+
+namespace mp {
+
+bool load_problem(int fd, problem &p) {
+	return load_problem(std::make_shared<const input_buffer>(fd), p);
+}
+
+bool load_problem(std::shared_ptr<const input_buffer> input, problem &p) {
+	if (input->failed())
+		return false;
+
+	// A binary matrix is already compressed, and is used in place.
+	// Otherwise, parse and compress.
+	if (is_binary_matrix(*input)) {
+		const int *ids = nullptr;
+		p.m = read_binary_matrix(input, ids, p.R, p.C);
+		if (!ids)
+			return false;
+		p.ids.assign(ids, ids + p.m.R + p.m.C);
+	} else {
+		matrix mat = parse_matrix(input->data(), input->size(),
+			input->max_size());
+		input.reset();
+		std::vector<int> idm;
+		p.m = compress(mat, idm);
+		p.R = mat.R;
+		p.C = mat.C;
+		p.ids.assign(p.m.R + p.m.C, 0);
+		for (int id = 0; id < (int)idm.size(); ++id)
+			if (idm[id] >= 0) p.ids[idm[id]] = id;
+	}
+	return true;
+}
+
+}
@@ -0,0 +1,34 @@
+#ifndef PROBLEM_H
+#define PROBLEM_H
+
+#include <memory>
+#include <vector>
+
+#include "../datastructures/matrix.h"
+#include "../io/input.h"
+
+namespace mp {
+
+// A compressed matrix, ready to be partitioned, and where it came from.
+struct problem {
+	matrix m;
+
+	// ids[i] is the row/column of the uncompressed R x C matrix that
+	// row/column i of m came from.
+	std::vector<int> ids;
+	int R = 0, C = 0;
+
+	problem() : m(0, 0) { }
+};
+
+// Read a matrix in MM or binary format (possibly compressed, see input.h)
+// from the given file descriptor, and compress it. Returns false if the
+// input could not be read.
+bool load_problem(int fd, problem &p);
+
+// As above, for input that was already read.
+bool load_problem(std::shared_ptr<const input_buffer> input, problem &p);
+
+}
+
+#endif
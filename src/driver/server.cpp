@@ -0,0 +1,352 @@
+#include "./server.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <new>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "./problem.h"
+#include "./work-queue.h"
+#include "../bb/bb-partitioner.h"
+#include "../bb/incumbent.h"
+#include "../io/input.h"
+#include "../io/output.h"
+#include "../partitioner/partition-util.h"
+
+namespace mp {
+
+static_assert(sizeof(request_header) == 32, "request header is packed");
+static_assert(sizeof(response_header) == 56, "response header is packed");
+
+constexpr char REQUEST_MAGIC[4] = {'M', 'P', 'R', 'Q'};
+constexpr char RESPONSE_MAGIC[4] = {'M', 'P', 'R', 'S'};
+
+namespace {
+
+bool read_full(int fd, void *data, size_t size) {
+	char *p = (char *)data;
+	while (size > 0) {
+		ssize_t n = ::read(fd, p, size);
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) return false;
+		p += n;
+		size -= n;
+	}
+	return true;
+}
+
+// A client connection. Closed once the client hung up and all its requests
+// are answered.
+struct connection {
+	int fd;
+
+	// Guards writing responses.
+	std::mutex write_lock;
+
+	explicit connection(int _fd) : fd(_fd) { }
+	~connection() { close(fd); }
+
+	bool send_full(const void *data, size_t size) {
+		const char *p = (const char *)data;
+		while (size > 0) {
+			ssize_t n = ::send(fd, p, size, MSG_NOSIGNAL);
+			if (n < 0 && errno == EINTR) continue;
+			if (n <= 0) return false;
+			p += n;
+			size -= n;
+		}
+		return true;
+	}
+};
+
+// A partition request, from arrival until it is answered.
+struct job {
+	std::shared_ptr<connection> conn;
+	uint64_t id;
+	float eps;
+	std::chrono::steady_clock::time_point arrival, deadline;
+	std::vector<char> payload;
+
+	// The incumbent of the running search, guarded by lock.
+	std::mutex lock;
+	incumbent *best = nullptr;
+	bool cancelled = false;
+
+	void cancel() {
+		std::lock_guard<std::mutex> guard(lock);
+		cancelled = true;
+		if (best != nullptr) best->cancel();
+	}
+};
+
+struct server_state {
+	bbparameters param;
+	int threads;
+	uint64_t max_payload;
+
+	// Requests waiting for a worker.
+	work_queue<std::shared_ptr<job>> queue;
+
+	// Requests not yet answered, by connection and id.
+	std::mutex jobs_lock;
+	std::map<std::pair<const connection *, uint64_t>, std::shared_ptr<job>>
+		jobs;
+
+	server_state(bbparameters _param, int _threads, uint64_t _max_payload)
+		: param(_param), threads(_threads), max_payload(_max_payload),
+		queue(std::numeric_limits<size_t>::max()) { }
+};
+
+// Answer a request without a partitioning.
+void answer_empty(connection &conn, uint64_t id, response_result result) {
+	response_header r;
+	memset(&r, 0, sizeof(r));
+	memcpy(r.magic, RESPONSE_MAGIC, sizeof(r.magic));
+	r.result = result;
+	r.id = id;
+	r.volume = -1;
+	std::lock_guard<std::mutex> guard(conn.write_lock);
+	conn.send_full(&r, sizeof(r));
+}
+
+// Answer a request that cannot be followed up (its payload cannot be
+// skipped), after which the connection is closed.
+void reject(connection &conn, uint64_t id, const char *reason) {
+	answer_empty(conn, id, response_result::invalid);
+	std::lock_guard<std::mutex> guard(debug_lock());
+	std::cerr << "Invalid request " << id << " (" << reason
+		<< "), closing connection." << std::endl;
+}
+
+// Solve a request with bb, the partitioner of the worker, which keeps its
+// buffers from one request to the next.
+void solve(server_state &state, job &j, bbpartitioner &bb) {
+	response_header r;
+	memset(&r, 0, sizeof(r));
+	memcpy(r.magic, RESPONSE_MAGIC, sizeof(r.magic));
+	r.id = j.id;
+	r.volume = -1;
+	std::vector<uint8_t> statuses;
+
+	problem p;
+	bool loaded = load_problem(std::make_shared<const input_buffer>(
+		std::move(j.payload), state.max_payload), p) && p.m.NZ > 0;
+	r.R = p.R;
+	r.C = p.C;
+	if (!loaded) {
+		r.result = response_result::invalid;
+	} else if (2 * max_partition_size(p.m.NZ, j.eps) < p.m.NZ) {
+		r.result = response_result::failed;
+	} else {
+		incumbent best(p.m.R + p.m.C, std::min(p.m.R, p.m.C) + 2);
+		{
+			std::lock_guard<std::mutex> guard(j.lock);
+			if (j.cancelled) best.cancel();
+			j.best = &best;
+		}
+		int value = bb.run(p.m, j.eps, j.deadline, best);
+		{
+			std::lock_guard<std::mutex> guard(j.lock);
+			j.best = nullptr;
+		}
+
+		if (value >= 0)
+			r.result = response_result::optimal;
+		else if (best.cancelled())
+			r.result = response_result::cancelled;
+		else
+			r.result = response_result::timeout;
+		r.nodes = bb.nodes();
+
+		// Empty rows/columns were removed, and may go to either side.
+		std::vector<status> s;
+		best.retrieve(s);
+		if (!s.empty() && s[0] != status::unassigned) {
+			r.volume = (int32_t)std::count(s.begin(), s.end(), status::cut);
+			statuses.assign(p.R + p.C, (uint8_t)part_side::empty);
+			for (size_t i = 0; i < s.size(); ++i)
+				statuses[p.ids[i]] = (uint8_t)to_part_side(s[i]);
+		}
+	}
+	r.size = statuses.size();
+	r.seconds = std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - j.arrival).count();
+
+	std::lock_guard<std::mutex> guard(j.conn->write_lock);
+	if (!j.conn->send_full(&r, sizeof(r))
+			|| !j.conn->send_full(statuses.data(), statuses.size())) {
+		std::lock_guard<std::mutex> guard(debug_lock());
+		std::cerr << "Could not answer request " << j.id << std::endl;
+	}
+}
+
+void work(server_state &state) {
+	bbpartitioner bb(state.param, state.threads);
+	std::shared_ptr<job> j;
+	while (state.queue.pop(j)) {
+		bool cancelled;
+		{
+			std::lock_guard<std::mutex> guard(j->lock);
+			cancelled = j->cancelled;
+		}
+		if (cancelled) {
+			// Answer right away, without loading the matrix.
+			answer_empty(*j->conn, j->id, response_result::cancelled);
+		} else {
+			try {
+				solve(state, *j, bb);
+			} catch (const std::exception &e) {
+				{
+					std::lock_guard<std::mutex> guard(j->lock);
+					j->best = nullptr;
+				}
+				answer_empty(*j->conn, j->id, response_result::invalid);
+				std::lock_guard<std::mutex> guard(debug_lock());
+				std::cerr << "Could not solve request " << j->id << ": "
+					<< e.what() << std::endl;
+			}
+		}
+
+		std::lock_guard<std::mutex> guard(state.jobs_lock);
+		auto it = state.jobs.find({j->conn.get(), j->id});
+		if (it != state.jobs.end() && it->second == j)
+			state.jobs.erase(it);
+		j.reset();
+	}
+}
+
+// Read the requests of a client until it hangs up, then cancel whatever it
+// left behind.
+void serve(std::shared_ptr<server_state> state,
+		std::shared_ptr<connection> conn) {
+	request_header h;
+	while (read_full(conn->fd, &h, sizeof(h))) {
+		if (memcmp(h.magic, REQUEST_MAGIC, sizeof(h.magic)) != 0) {
+			std::lock_guard<std::mutex> guard(debug_lock());
+			std::cerr << "Invalid request, closing connection." << std::endl;
+			break;
+		}
+
+		if (h.type != request_type::partition
+				&& h.type != request_type::cancel) {
+			reject(*conn, h.id, "unknown type");
+			break;
+		}
+		if (h.type == request_type::cancel) {
+			std::lock_guard<std::mutex> guard(state->jobs_lock);
+			auto it = state->jobs.find({conn.get(), h.id});
+			if (it != state->jobs.end())
+				it->second->cancel();
+			continue;
+		}
+
+		auto j = std::make_shared<job>();
+		j->conn = conn;
+		j->id = h.id;
+		j->eps = h.eps;
+		j->arrival = std::chrono::steady_clock::now();
+		j->deadline = h.deadline_ms > 0
+			? j->arrival + std::chrono::milliseconds(h.deadline_ms)
+			: std::chrono::steady_clock::time_point::max();
+		if (h.size > state->max_payload) {
+			reject(*conn, h.id, "matrix too large");
+			break;
+		}
+		try {
+			j->payload.resize(h.size);
+		} catch (const std::bad_alloc &) {
+			reject(*conn, h.id, "out of memory");
+			break;
+		}
+		if (!read_full(conn->fd, j->payload.data(), h.size))
+			break;
+		if (!std::isfinite(h.eps) || h.eps < 0.0f) {
+			answer_empty(*conn, h.id, response_result::invalid);
+			continue;
+		}
+		{
+			std::lock_guard<std::mutex> guard(state->jobs_lock);
+			state->jobs[{conn.get(), h.id}] = j;
+		}
+		state->queue.push(j);
+	}
+
+	std::lock_guard<std::mutex> guard(state->jobs_lock);
+	for (auto &entry : state->jobs)
+		if (entry.first.first == conn.get())
+			entry.second->cancel();
+}
+
+}
+
+bool run_server(const std::string &path, bbparameters param, int threads,
+		int parallel, uint64_t max_payload) {
+	bool valid;
+	std::string error;
+	std::tie(valid, error) = param.valid();
+	if (!valid) {
+		std::cerr << "Invalid parameters: " << error << std::endl;
+		return false;
+	}
+
+	sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (path.size() >= sizeof(addr.sun_path)) {
+		std::cerr << "Socket path too long: " << path << std::endl;
+		return false;
+	}
+	strcpy(addr.sun_path, path.c_str());
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	unlink(path.c_str());
+	if (fd < 0 || bind(fd, (sockaddr *)&addr, sizeof(addr)) != 0
+			|| listen(fd, SOMAXCONN) != 0) {
+		std::cerr << "Could not listen on " << path << ": "
+			<< strerror(errno) << std::endl;
+		if (fd >= 0) close(fd);
+		return false;
+	}
+	std::cerr << "Listening on " << path << std::endl;
+
+	auto state = std::make_shared<server_state>(param, threads,
+		max_payload);
+	std::vector<std::thread> workers;
+	for (int t = 0; t < std::max(1, parallel); ++t)
+		workers.emplace_back(work, std::ref(*state));
+
+	// Every client is served by its own thread, which only reads requests.
+	while (true) {
+		int client = accept(fd, nullptr, nullptr);
+		if (client < 0) {
+			if (errno == EINTR || errno == ECONNABORTED) continue;
+			std::cerr << "Could not accept connection: " << strerror(errno)
+				<< std::endl;
+			break;
+		}
+		std::thread(serve, state, std::make_shared<connection>(client))
+			.detach();
+	}
+
+	close(fd);
+	state->queue.close();
+	for (std::thread &t : workers) t.join();
+	return false;
+}
+
+}
@@ -0,0 +1,64 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <cstdint>
+#include <string>
+
+#include "../bb/bb-parameters.h"
+#include "../partitioner/partition-util.h"
+
+namespace mp {
+
+// A server partitioning matrices sent over a Unix domain socket. A client
+// sends any number of requests over a connection, which are solved
+// concurrently and answered as they finish, in any order. All integers are in
+// native byte order.
+//
+// A partition request is a request_header followed by size bytes holding the
+// matrix, in any format mp reads (see input.h and binary.h). A cancel request
+// is a header only, with the id of the request to cancel. The response is a
+// response_header followed by size bytes: the status of every row, then
+// every column, of the uncompressed matrix (see part_side).
+
+enum class request_type : uint32_t { partition = 0, cancel = 1 };
+
+struct request_header {
+	char magic[4];			// "MPRQ"
+	request_type type;
+	uint64_t id;			// Chosen by the client, unique per connection.
+	float eps;
+	uint32_t deadline_ms;	// After arrival, 0 for no deadline.
+	uint64_t size;
+};
+
+enum class response_result : uint32_t {
+	optimal = 0,		// The partitioning is optimal.
+	timeout = 1,		// The deadline passed, partitioning is the best found.
+	cancelled = 2,		// Cancelled, partitioning is the best found (if any).
+	failed = 3,			// No partitioning exists with this eps.
+	invalid = 4			// The request or matrix is invalid.
+};
+
+struct response_header {
+	char magic[4];			// "MPRS"
+	response_result result;
+	uint64_t id;
+	int64_t nodes;			// B&B nodes explored.
+	double seconds;			// Since the request arrived.
+	uint64_t size;			// R + C if a partitioning is included, else 0.
+	int32_t volume;			// -1 if no partitioning is included.
+	int32_t R, C;			// Size of the uncompressed matrix.
+	int32_t reserved;
+};
+
+// Serve requests on a socket at path until the process is killed, solving
+// up to parallel requests at the same time. Every search uses the given
+// parameters and number of threads. Requests with a matrix of more than
+// max_payload bytes, or an unknown type, are answered as invalid and close
+// their connection. Returns false if the socket could not be set up.
+bool run_server(const std::string &path, bbparameters param, int threads,
+	int parallel, uint64_t max_payload);
+
+}
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef WORK_QUEUE_H
+#define WORK_QUEUE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+namespace mp {
+
+// A queue handing items from one stage of a pipeline to the next. Pushing
+// blocks while the queue is full, popping while it is empty and open.
+template <typename T>
+class work_queue {
+public:
+	explicit work_queue(size_t _capacity) : capacity(_capacity) { }
+
+	void push(T item) {
+		std::unique_lock<std::mutex> guard(lock);
+		not_full.wait(guard, [this]() { return items.size() < capacity; });
+		items.push_back(std::move(item));
+		not_empty.notify_one();
+	}
+
+	// Returns false once the queue is closed and empty.
+	bool pop(T &item) {
+		std::unique_lock<std::mutex> guard(lock);
+		not_empty.wait(guard, [this]() { return !items.empty() || closed; });
+		if (items.empty()) return false;
+		item = std::move(items.front());
+		items.pop_front();
+		not_full.notify_one();
+		return true;
+	}
+
+	// No more items will be pushed.
+	void close() {
+		std::lock_guard<std::mutex> guard(lock);
+		closed = true;
+		not_empty.notify_all();
+	}
+
+private:
+	size_t capacity;
+	std::deque<T> items;
+	bool closed = false;
+	std::mutex lock;
+	std::condition_variable not_empty, not_full;
+};
+
+}
+
+#endif
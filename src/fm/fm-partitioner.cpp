@@ -0,0 +1,266 @@
+#include "./fm-partitioner.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <random>
+
+namespace mp {
+
+// A pass stops after this many moves without finding a better partitioning.
+constexpr size_t FM_STALL = 1000;
+
+// Gains of moving a single nonzero lie in [-2, 2].
+constexpr int FM_GAINS = 5;
+
+struct fmpartitioner::fmstate {
+	const matrix &m;
+	const int max_size;
+
+	// Nonzeros are numbered row by row. first[r] is the id of the first
+	// nonzero in row r, and nets[2*v], nets[2*v+1] are the row and column
+	// of nonzero v.
+	std::vector<int> first, nets;
+
+	// Side of each nonzero, and the number of nonzeros on either side of
+	// each row/column.
+	std::vector<int> side, count[2];
+	int size[2] = {0, 0}, cut = 0;
+
+	// Gain buckets (doubly linked lists) per side a nonzero moves from.
+	std::vector<int> gain, next, prev;
+	std::vector<bool> locked;
+	int head[2][FM_GAINS];
+
+	fmstate(const matrix &_m, int _max_size) : m(_m), max_size(_max_size),
+			first(_m.R + 1, 0), nets(2 * _m.NZ), side(_m.NZ, 0),
+			gain(_m.NZ), next(_m.NZ), prev(_m.NZ), locked(_m.NZ) {
+		for (int r = 0; r < m.R; ++r) {
+			first[r + 1] = first[r] + (int)m[r].size();
+			for (size_t i = 0; i < m[r].size(); ++i) {
+				nets[2 * (first[r] + i)] = r;
+				nets[2 * (first[r] + i) + 1] = m[r][i].rc;
+			}
+		}
+		count[0].assign(m.R + m.C, 0);
+		count[1].assign(m.R + m.C, 0);
+	}
+
+	// Id of the j-th nonzero of row/column l.
+	int id(int l, int j) const {
+		if (l < m.R) return first[l] + j;
+		return first[m[l][j].rc] + m[l][j].index;
+	}
+
+	bool is_cut(int n) const {
+		return count[0][n] > 0 && count[1][n] > 0;
+	}
+
+	// Recompute counts, sizes and the volume from scratch.
+	void recount() {
+		std::fill(count[0].begin(), count[0].end(), 0);
+		std::fill(count[1].begin(), count[1].end(), 0);
+		size[0] = size[1] = 0;
+		for (int v = 0; v < m.NZ; ++v) {
+			++count[side[v]][nets[2 * v]];
+			++count[side[v]][nets[2 * v + 1]];
+			++size[side[v]];
+		}
+		cut = 0;
+		for (int n = 0; n < m.R + m.C; ++n)
+			if (is_cut(n)) ++cut;
+	}
+
+	// Decrease in volume when moving v to the other side.
+	int compute_gain(int v) const {
+		int a = side[v], b = 1 - a, g = 0;
+		for (int n : {nets[2 * v], nets[2 * v + 1]}) {
+			if (count[a][n] == 1) ++g;
+			if (count[b][n] == 0) --g;
+		}
+		return g;
+	}
+
+	void insert(int v) {
+		int &h = head[side[v]][gain[v] + 2];
+		prev[v] = -1;
+		next[v] = h;
+		if (h >= 0) prev[h] = v;
+		h = v;
+	}
+
+	void remove(int v) {
+		if (prev[v] >= 0) next[prev[v]] = next[v];
+		else head[side[v]][gain[v] + 2] = next[v];
+		if (next[v] >= 0) prev[next[v]] = prev[v];
+	}
+
+	// Move v to the other side, only maintaining counts and volume.
+	void flip(int v) {
+		int a = side[v], b = 1 - a;
+		for (int n : {nets[2 * v], nets[2 * v + 1]}) {
+			bool was_cut = is_cut(n);
+			--count[a][n];
+			++count[b][n];
+			cut += (int)is_cut(n) - (int)was_cut;
+		}
+		--size[a];
+		++size[b];
+		side[v] = b;
+	}
+
+	// Move v to the other side, and update the gains of the unlocked
+	// nonzeros on its row and column if they may have changed.
+	void move(int v) {
+		int a = side[v], b = 1 - a;
+		bool critical[2];
+		for (int k = 0; k < 2; ++k) {
+			int n = nets[2 * v + k];
+			critical[k] = count[b][n] <= 1 || count[a][n] <= 2;
+		}
+		flip(v);
+		for (int k = 0; k < 2; ++k) {
+			if (!critical[k]) continue;
+			int n = nets[2 * v + k];
+			for (int j = 0; j < (int)m[n].size(); ++j) {
+				int u = id(n, j);
+				if (locked[u]) continue;
+				remove(u);
+				gain[u] = compute_gain(u);
+				insert(u);
+			}
+		}
+	}
+
+	// A single FM pass: move every nonzero at most once, greedily by gain,
+	// and roll back to the best partitioning seen.
+	void pass() {
+		for (int a = 0; a < 2; ++a)
+			std::fill(head[a], head[a] + FM_GAINS, -1);
+		for (int v = 0; v < m.NZ; ++v) {
+			locked[v] = false;
+			gain[v] = compute_gain(v);
+			insert(v);
+		}
+
+		std::vector<int> moves;
+		size_t best = 0;
+		int best_cut = cut, best_imbalance = std::abs(size[0] - size[1]);
+		while (moves.size() - best < FM_STALL) {
+			// Pick the move with the highest gain that keeps the balance,
+			// preferring to move away from the larger side.
+			int v = -1, vg = -1;
+			for (int a = 0; a < 2; ++a) {
+				if (size[1 - a] + 1 > max_size) continue;
+				for (int g = FM_GAINS - 1; g >= 0; --g) {
+					if (head[a][g] < 0) continue;
+					if (g > vg || (g == vg && size[a] > size[1 - a])) {
+						v = head[a][g];
+						vg = g;
+					}
+					break;
+				}
+			}
+			if (v < 0) break;
+
+			remove(v);
+			locked[v] = true;
+			move(v);
+			moves.push_back(v);
+
+			int imbalance = std::abs(size[0] - size[1]);
+			if (cut < best_cut
+					|| (cut == best_cut && imbalance < best_imbalance)) {
+				best = moves.size();
+				best_cut = cut;
+				best_imbalance = imbalance;
+			}
+		}
+
+		while (moves.size() > best) {
+			flip(moves.back());
+			moves.pop_back();
+		}
+	}
+};
+
+void fmpartitioner::grow(fmstate &st, int start) const {
+	const matrix &m = st.m;
+
+	// Breadth first over the rows/columns, assigning the nonzeros met to
+	// the first side until it holds half of them.
+	std::fill(st.side.begin(), st.side.end(), 1);
+	std::vector<bool> visited(m.R + m.C, false);
+	std::vector<int> queue;
+	queue.reserve(m.R + m.C);
+	queue.push_back(start);
+	visited[start] = true;
+
+	int target = m.NZ / 2, first = 0, unvisited = 0;
+	for (size_t qi = 0; first < target; ++qi) {
+		// Continue in another component when this one is exhausted.
+		if (qi == queue.size()) {
+			while (visited[unvisited]) ++unvisited;
+			queue.push_back(unvisited);
+			visited[unvisited] = true;
+		}
+
+		int l = queue[qi];
+		for (int j = 0; j < (int)m[l].size() && first < target; ++j) {
+			int v = st.id(l, j);
+			if (st.side[v] == 1) {
+				st.side[v] = 0;
+				++first;
+			}
+			if (!visited[m[l][j].rc]) {
+				visited[m[l][j].rc] = true;
+				queue.push_back(m[l][j].rc);
+			}
+		}
+	}
+	st.recount();
+}
+
+int fmpartitioner::refine(fmstate &st) const {
+	for (;;) {
+		int before = st.cut;
+		st.pass();
+		if (st.cut >= before) break;
+	}
+	return st.cut;
+}
+
+bool fmpartitioner::partition(const matrix &m, std::vector<status> &row,
+		std::vector<status> &col, float epsilon, long long tl) {
+	int max_size = max_partition_size(m.NZ, epsilon);
+	if (2 * max_size < m.NZ || m.R + m.C == 0)
+		return false;
+
+	// Refine from a number of random starts, and keep the best result.
+	std::mt19937 rng(seed);
+	fmstate st(m, max_size);
+	std::vector<int> best_side;
+	int best_cut = std::numeric_limits<int>::max();
+	for (int i = 0; i < std::max(1, starts); ++i) {
+		grow(st, (int)(rng() % (unsigned)(m.R + m.C)));
+		int cut = refine(st);
+		if (cut < best_cut) {
+			best_cut = cut;
+			best_side = st.side;
+		}
+	}
+	st.side = best_side;
+	st.recount();
+
+	// A row/column is cut iff it has nonzeros on both sides.
+	row.resize(m.R);
+	col.resize(m.C);
+	for (int l = 0; l < m.R + m.C; ++l) {
+		status s = st.is_cut(l) ? status::cut
+			: st.count[0][l] > 0 ? status::red : status::blue;
+		(l < m.R ? row[l] : col[l - m.R]) = s;
+	}
+	return true;
+}
+
+}
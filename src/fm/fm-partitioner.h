@@ -0,0 +1,44 @@
+#ifndef FMPARTITIONER_H
+#define FMPARTITIONER_H
+
+#include <vector>
+
+#include "../datastructures/matrix.h"
+#include "../partitioner/partitioner.h"
+#include "../partitioner/partition-util.h"
+
+namespace mp {
+
+// Heuristic partitioner. Grows a number of initial bipartitionings of the
+// nonzeros from random rows/columns and refines each with
+// Fiduccia-Mattheyses passes, where every row/column is a net and every
+// nonzero lies on exactly two nets. A row/column is cut iff it holds
+// nonzeros of both sides. Runs in (near) linear time per pass, and always
+// succeeds if a balanced partitioning exists.
+class fmpartitioner : public partitioner {
+  private:
+	// Seed for the starting rows/columns, and the number of starts.
+	unsigned seed;
+	int starts;
+
+	// State of a single refinement.
+	struct fmstate;
+
+	// Grow an initial bipartitioning from the given row/column.
+	void grow(fmstate &st, int start) const;
+
+	// Run FM passes until no pass improves. Returns the resulting volume.
+	int refine(fmstate &st) const;
+
+  public:
+	fmpartitioner(unsigned _seed = 0, int _starts = 4)
+		: seed(_seed), starts(_starts) { }
+
+	// The time limit is ignored, this partitioner is fast.
+	virtual bool partition(const matrix &m, std::vector<status> &row,
+		std::vector<status> &col, float epsilon, long long tl);
+};
+
+}
+
+#endif
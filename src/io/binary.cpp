@@ -0,0 +1,152 @@
+#include "./binary.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+
+#include "./output.h"
+
+namespace mp {
+
+// Increased whenever the layout changes.
+constexpr uint32_t BINARY_VERSION = 1;
+constexpr char BINARY_MAGIC[8] = {'M', 'P', 'M', 'A', 'T', 'R', 'I', 'X'};
+
+// The header, followed by first[R + C + 1] (int32), entries[2 * NZ] (pairs of
+// int32) and ids[R + C] (int32). Every part is 4-byte aligned.
+struct binary_header {
+	char magic[8];
+	uint32_t version;
+	// Detects files written with a different byte order.
+	uint32_t byte_order;
+	int32_t R, C, NZ, Cmax;
+	// Dimensions of the uncompressed matrix.
+	int32_t original_R, original_C;
+};
+
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+static_assert(sizeof(entry) == 2 * sizeof(int32_t),
+	"entries are stored as pairs of int32");
+
+matrix binary_error(const std::string &reason) {
+	std::lock_guard<std::mutex> guard(debug_lock());
+	std::cerr << "Error reading binary matrix: " << reason << '\n';
+	return matrix(0, 0);
+}
+
+// Check that the arrays of a binary matrix describe a valid matrix: offsets
+// that do not decrease, rows (then columns) holding their entries in order
+// (duplicates are kept by the parser), entries that link to each other, Cmax
+// as stored, and ids in range. Returns an empty string if so, or else the reason.
+std::string check_binary_matrix(const binary_header &h, const int *first,
+		const entry *entries, const int *ids) {
+	int R = h.R, C = h.C;
+	if (h.original_R < R || h.original_C < C
+			|| (long long)h.original_R + h.original_C > INT32_MAX)
+		return "invalid dimensions of the uncompressed matrix.";
+	if (first[0] != 0 || first[R] != h.NZ
+			|| first[R + C] != 2 * (long long)h.NZ)
+		return "invalid offsets.";
+	int Cmax = 0;
+	for (int rc = 0; rc < R + C; ++rc) {
+		if (first[rc + 1] < first[rc])
+			return "invalid offsets.";
+		Cmax = std::max(Cmax, first[rc + 1] - first[rc]);
+	}
+	if (Cmax != h.Cmax)
+		return "Cmax does not match the offsets.";
+
+	// Every row entry points to a distinct column entry pointing back, so
+	// the column entries are covered as well.
+	for (int rc = 0; rc < R + C; ++rc) {
+		int lo = rc < R ? R : 0, hi = rc < R ? R + C : R;
+		for (int i = first[rc]; i < first[rc + 1]; ++i) {
+			const entry &e = entries[i];
+			if (e.rc < lo || e.rc >= hi
+					|| (i > first[rc] && e.rc < entries[i - 1].rc)
+					|| e.index < 0
+					|| e.index >= first[e.rc + 1] - first[e.rc])
+				return "invalid entries.";
+			const entry &back = entries[first[e.rc] + e.index];
+			if (back.rc != rc || back.index != i - first[rc])
+				return "invalid entries.";
+		}
+	}
+
+	for (int rc = 0; rc < R + C; ++rc) {
+		if (rc < R ? ids[rc] < 0 || ids[rc] >= h.original_R
+				: ids[rc] < h.original_R
+					|| ids[rc] >= h.original_R + h.original_C)
+			return "invalid ids.";
+	}
+	return "";
+}
+
+bool is_binary_matrix(const input_buffer &input) {
+	return input.size() >= sizeof(BINARY_MAGIC)
+		&& memcmp(input.data(), BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0;
+}
+
+matrix read_binary_matrix(std::shared_ptr<const input_buffer> input,
+		const int *&ids, int &R, int &C) {
+	binary_header h;
+	if (input->size() < sizeof(h))
+		return binary_error("file is truncated.");
+	memcpy(&h, input->data(), sizeof(h));
+	if (h.version != BINARY_VERSION)
+		return binary_error("unsupported version "
+			+ std::to_string(h.version) + ".");
+	if (h.byte_order != BYTE_ORDER_MARK)
+		return binary_error("file was written with another byte order.");
+	if (h.R < 0 || h.C < 0 || h.NZ < 0)
+		return binary_error("invalid dimensions.");
+
+	size_t rc = (size_t)h.R + h.C;
+	size_t size = sizeof(h) + (rc + 1) * sizeof(int32_t)
+		+ 2 * (size_t)h.NZ * sizeof(entry) + rc * sizeof(int32_t);
+	if (input->size() != size)
+		return binary_error("file size does not match its dimensions.");
+
+	const char *p = input->data() + sizeof(h);
+	const int *first = (const int *)p;
+	p += (rc + 1) * sizeof(int32_t);
+	const entry *entries = (const entry *)p;
+	p += 2 * (size_t)h.NZ * sizeof(entry);
+	std::string reason = check_binary_matrix(h, first, entries,
+		(const int *)p);
+	if (!reason.empty())
+		return binary_error(reason);
+
+	ids = (const int *)p;
+	R = h.original_R;
+	C = h.original_C;
+	return matrix(h.R, h.C, h.NZ, h.Cmax, first, entries, input);
+}
+
+bool write_binary_matrix(const std::string &path, const matrix &m,
+		const std::vector<int> &ids, int R, int C) {
+	binary_header h;
+	memcpy(h.magic, BINARY_MAGIC, sizeof(h.magic));
+	h.version = BINARY_VERSION;
+	h.byte_order = BYTE_ORDER_MARK;
+	h.R = m.R;
+	h.C = m.C;
+	h.NZ = m.NZ;
+	h.Cmax = m.Cmax;
+	h.original_R = R;
+	h.original_C = C;
+
+	size_t rc = (size_t)m.R + m.C;
+	std::ofstream file(path, std::ios::binary);
+	file.write((const char *)&h, sizeof(h));
+	file.write((const char *)m.offsets(), (rc + 1) * sizeof(int32_t));
+	file.write((const char *)m.data(), 2 * (size_t)m.NZ * sizeof(entry));
+	file.write((const char *)ids.data(), rc * sizeof(int32_t));
+	return (bool)file;
+}
+
+}
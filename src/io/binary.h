@@ -0,0 +1,37 @@
+#ifndef BINARY_H
+#define BINARY_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "./input.h"
+#include "../datastructures/matrix.h"
+
+namespace mp {
+
+// A binary format for compressed matrices, so they can be loaded without
+// parsing, sorting or compressing. The file holds a header (see binary.cpp),
+// the matrix in the layout of matrix::offsets() and matrix::data(), and for
+// each row/column the row/column of the uncompressed matrix it came from.
+// Integers are stored in native byte order.
+
+// Whether the input holds a matrix in binary format.
+bool is_binary_matrix(const input_buffer &input);
+
+// Load a matrix in binary format without copying it: the matrix and ids
+// refer to the input, which the matrix keeps alive. ids[i] is the row/column
+// of the uncompressed R x C matrix that row/column i came from. The whole
+// matrix is checked first; if it is invalid, ids is left untouched and an
+// empty matrix is returned.
+matrix read_binary_matrix(std::shared_ptr<const input_buffer> input,
+	const int *&ids, int &R, int &C);
+
+// Write a compressed matrix in binary format, with ids as above. Returns
+// whether this succeeded.
+bool write_binary_matrix(const std::string &path, const matrix &m,
+	const std::vector<int> &ids, int R, int C);
+
+}
+
+#endif
@@ -0,0 +1,239 @@
+#include "./compressed.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+
+#include <unistd.h>
+#include <zlib.h>
+
+#include "./output.h"
+
+namespace mp {
+
+// Size of the chunks read from the input and decompressed at once.
+constexpr size_t CHUNK = 1 << 18;
+
+// Blocks of a tar archive.
+constexpr size_t TAR_BLOCK = 512;
+
+bool is_gzip(const char *data, size_t size) {
+	return size >= 2 && (unsigned char)data[0] == 0x1f
+		&& (unsigned char)data[1] == 0x8b;
+}
+
+namespace {
+
+// Extracts one member from a tar archive handed over in pieces, see
+// decompress_gzip. Only ustar archives (with GNU long names) are supported.
+class tar_extractor {
+public:
+	tar_extractor(std::vector<char> &_out, size_t _limit)
+		: out(_out), limit(_limit) {}
+
+	void feed(const char *data, size_t size);
+
+	// Whether the archive held a .mtx member.
+	bool found() const { return kept != NONE; }
+
+	// Whether the member to keep was larger than the limit, which ends the
+	// extraction.
+	bool too_large() const { return large; }
+
+private:
+	std::vector<char> &out;
+	size_t limit;
+	bool large = false;
+
+	// The header being read, the name of the current member (and the next
+	// one if given by a GNU long name entry), and the data of the current
+	// member left, followed by its padding.
+	std::string header, name, long_name;
+	size_t data_left = 0, padding_left = 0;
+	bool reading_long_name = false, finished = false;
+
+	// Which member out holds: none, the first .mtx one, or NAME/NAME.mtx.
+	enum { NONE, FIRST, NAMED } kept = NONE;
+	bool keeping = false;
+
+	void start_member();
+};
+
+void tar_extractor::start_member() {
+	// Two zero blocks end the archive.
+	if (header.find_first_not_of('\0') == std::string::npos) {
+		finished = true;
+		return;
+	}
+
+	size_t size = strtoull(std::string(header, 124, 12).c_str(), nullptr, 8);
+	char type = header[156];
+	std::string member = long_name;
+	long_name.clear();
+	if (member.empty()) {
+		member = std::string(header.c_str(), strnlen(header.c_str(), 100));
+		if (header.compare(257, 5, "ustar") == 0 && header[345] != '\0')
+			member = std::string(header.c_str() + 345,
+				strnlen(header.c_str() + 345, 155)) + "/" + member;
+	}
+
+	data_left = size;
+	padding_left = (TAR_BLOCK - size % TAR_BLOCK) % TAR_BLOCK;
+	reading_long_name = type == 'L';
+	keeping = false;
+	if (reading_long_name && size > limit) {
+		large = true;
+		finished = true;
+		return;
+	}
+	if (type != '0' && type != '\0') return;
+
+	// Check for NAME/NAME.mtx, or any .mtx file.
+	size_t slash = member.rfind('/');
+	std::string base = member.substr(slash == std::string::npos ? 0 : slash + 1);
+	if (base.size() < 4 || base.compare(base.size() - 4, 4, ".mtx") != 0)
+		return;
+	std::string dir = slash == std::string::npos ? ""
+		: member.substr(0, slash);
+	size_t dslash = dir.rfind('/');
+	if (dslash != std::string::npos) dir = dir.substr(dslash + 1);
+	bool named = dir + ".mtx" == base;
+
+	if (kept == NAMED || (kept == FIRST && !named)) return;
+	if (size > limit) {
+		large = true;
+		finished = true;
+		return;
+	}
+	kept = named ? NAMED : FIRST;
+	keeping = true;
+	out.clear();
+	out.reserve(size);
+}
+
+void tar_extractor::feed(const char *data, size_t size) {
+	while (size > 0 && !finished) {
+		if (data_left > 0) {
+			size_t n = std::min(size, data_left);
+			if (keeping)
+				out.insert(out.end(), data, data + n);
+			else if (reading_long_name)
+				long_name.append(data, strnlen(data, n));
+			data += n; size -= n; data_left -= n;
+		} else if (padding_left > 0) {
+			size_t n = std::min(size, padding_left);
+			data += n; size -= n; padding_left -= n;
+		} else {
+			size_t n = std::min(size, TAR_BLOCK - header.size());
+			header.append(data, n);
+			data += n; size -= n;
+			if (header.size() == TAR_BLOCK) {
+				start_member();
+				header.clear();
+			}
+		}
+	}
+}
+
+}
+
+bool decompress_gzip(const char *data, size_t size, int fd,
+		std::vector<char> &out, size_t limit) {
+	z_stream zs;
+	memset(&zs, 0, sizeof(zs));
+	// Accept gzip headers (32) with the maximal window (15).
+	if (inflateInit2(&zs, 15 + 32) != Z_OK) {
+		std::lock_guard<std::mutex> guard(debug_lock());
+		std::cerr << "Error decompressing input: could not initialize zlib."
+			<< '\n';
+		return false;
+	}
+
+	// The first block tells whether this is a tar archive. Until then, and
+	// for plain gzip, decompress into out directly.
+	std::vector<char> in, chunk(CHUNK);
+	std::vector<char> archive;
+	tar_extractor tar(out, limit);
+	bool is_tar = false, checked = false, ok = true;
+	std::string reason;
+	out.clear();
+
+	// Only read more input once all output for the current input is out.
+	int ret = Z_OK;
+	bool pending = false;
+	while (ok) {
+		if (zs.avail_in == 0 && !pending) {
+			if (size > 0) {
+				zs.next_in = (Bytef *)data;
+				zs.avail_in = (uInt)std::min(size, (size_t)1 << 30);
+				data += zs.avail_in;
+				size -= zs.avail_in;
+			} else if (fd >= 0) {
+				in.resize(CHUNK);
+				ssize_t n = read(fd, in.data(), in.size());
+				if (n < 0) ok = false;
+				if (n <= 0) break;
+				zs.next_in = (Bytef *)in.data();
+				zs.avail_in = (uInt)n;
+			} else {
+				break;
+			}
+		}
+
+		// Concatenated gzip streams are decompressed one after the other.
+		if (ret == Z_STREAM_END)
+			inflateReset(&zs);
+
+		zs.next_out = (Bytef *)chunk.data();
+		zs.avail_out = (uInt)chunk.size();
+		ret = inflate(&zs, Z_NO_FLUSH);
+		if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+			ok = false;
+			break;
+		}
+		size_t n = chunk.size() - zs.avail_out;
+		pending = zs.avail_out == 0;
+
+		if (is_tar) {
+			tar.feed(chunk.data(), n);
+		} else {
+			out.insert(out.end(), chunk.data(), chunk.data() + n);
+			if (!checked && out.size() >= TAR_BLOCK) {
+				checked = true;
+				if (memcmp(out.data() + 257, "ustar", 5) == 0) {
+					is_tar = true;
+					archive.swap(out);
+					tar.feed(archive.data(), archive.size());
+					std::vector<char>().swap(archive);
+				}
+			}
+		}
+		if (is_tar ? tar.too_large() : out.size() > limit) {
+			reason = "more than " + std::to_string(limit) + " bytes.";
+			ok = false;
+			break;
+		}
+	}
+	if (ok && ret != Z_STREAM_END)
+		ok = false;
+	if (reason.empty())
+		reason = zs.msg != nullptr ? zs.msg : "truncated stream.";
+	inflateEnd(&zs);
+
+	if (!ok) {
+		std::lock_guard<std::mutex> guard(debug_lock());
+		std::cerr << "Error decompressing input: " << reason << '\n';
+		return false;
+	}
+	if (is_tar && !tar.found()) {
+		std::lock_guard<std::mutex> guard(debug_lock());
+		std::cerr << "Error decompressing input: no .mtx file in archive."
+			<< '\n';
+		return false;
+	}
+	return true;
+}
+
+}
@@ -0,0 +1,24 @@
+#ifndef COMPRESSED_H
+#define COMPRESSED_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mp {
+
+// Whether the data starts like a gzip stream.
+bool is_gzip(const char *data, size_t size);
+
+// Decompress a gzip stream into out. The stream consists of the given data,
+// followed by whatever can still be read from fd (if fd >= 0), and is
+// decompressed as it is read. If it holds a tar archive, only one member is
+// kept: NAME/NAME.mtx as in the SuiteSparse Matrix Collection, or otherwise
+// the first .mtx file. Returns false (with an error) on failure, or once out
+// would hold more than limit bytes.
+bool decompress_gzip(const char *data, size_t size, int fd,
+	std::vector<char> &out, size_t limit = SIZE_MAX);
+
+}
+
+#endif
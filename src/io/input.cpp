@@ -1,15 +1,30 @@
 #include "./input.h"
 
-#include <fstream>
+#include <algorithm>
+#include <climits>
+#include <cstring>
 #include <iostream>
 #include <iterator>
+#include <mutex>
 #include <sstream>
+#include <thread>
 #include <utility>
 #include <vector>
 
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "./compressed.h"
+#include "./output.h"
+
 namespace mp {
 
+// Nonzeros are only parsed in parallel in chunks of at least this many bytes.
+constexpr size_t MIN_CHUNK = 1 << 20;
+
 matrix error(const std::string &reason) {
+	std::lock_guard<std::mutex> guard(debug_lock());
 	std::cerr << "Error reading matrix: " << reason << '\n';
 	std::vector<std::pair<int, int>> tmp;
 	return matrix(0, 0, tmp);
@@ -23,16 +38,176 @@ std::vector<std::string> tokenize(const std::string &line) {
 		std::istream_iterator<std::string>{}};
 }
 
-matrix read_matrix(std::istream &stream) {
+// Retrieve the line starting at p, and move p past it.
+std::string next_line(const char *&p, const char *end) {
+	const char *eol = (const char *)memchr(p, '\n', end - p);
+	if (eol == nullptr) eol = end;
+	std::string line(p, eol);
+	p = eol < end ? eol + 1 : end;
+	return line;
+}
+
+inline bool is_blank(char ch) {
+	return ch == ' ' || ch == '\t' || ch == '\r';
+}
+
+// Scan an integer at p (after blanks), and move p past it. Fails on integers
+// that do not fit in an int.
+inline bool scan_int(const char *&p, const char *end, int &value) {
+	while (p < end && is_blank(*p)) ++p;
+	bool negative = p < end && *p == '-';
+	if (p < end && (*p == '-' || *p == '+')) ++p;
+	if (p == end || *p < '0' || *p > '9') return false;
+	long long v = 0;
+	while (p < end && *p >= '0' && *p <= '9') {
+		v = 10 * v + (*p++ - '0');
+		if (v > INT_MAX) return false;
+	}
+	value = (int)(negative ? -v : v);
+	return true;
+}
+
+// Parse a whole token as a non-negative int.
+bool parse_count(const std::string &token, int &value) {
+	const char *p = token.data(), *end = p + token.size();
+	return scan_int(p, end, value) && p == end && value >= 0;
+}
+
+// Parse the nonzeros on the lines in [p, end), at most limit of them, of an
+// R x C matrix, and append them to out. Every nonzero is followed by the
+// given number of values, which are skipped without converting them. Returns
+// the number of nonzeros read, -1 if a line could not be read, or -2 if a
+// nonzero lies outside the matrix.
+long long parse_nonzeros(const char *p, const char *end, int elements,
+		bool symmetric, int R, int C, long long limit,
+		std::vector<std::pair<int, int>> &out) {
+	long long count = 0;
+	while (p < end && count < limit) {
+		// Skip empty lines.
+		while (p < end && is_blank(*p)) ++p;
+		if (p == end) break;
+		if (*p == '\n') {
+			++p;
+			continue;
+		}
+
+		int j, k;
+		if (!scan_int(p, end, j) || !scan_int(p, end, k))
+			return -1;
+		for (int l = 0; l < elements; ++l) {
+			while (p < end && is_blank(*p)) ++p;
+			if (p == end || *p == '\n') return -1;
+			while (p < end && !is_blank(*p) && *p != '\n') ++p;
+		}
+		const char *eol = (const char *)memchr(p, '\n', end - p);
+		p = eol == nullptr ? end : eol + 1;
+
+		j -= 1;
+		k -= 1;
+		if (j < 0 || j >= R || k < 0 || k >= C
+				|| (symmetric && (k >= R || j >= C)))
+			return -2;
+
+		out.push_back({j, k});
+		if (symmetric && j != k)
+			out.push_back({k, j});
+		++count;
+	}
+	return count;
+}
+
+input_buffer::input_buffer(int fd) {
+	struct stat st;
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+		map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map != MAP_FAILED) {
+			map_size = st.st_size;
+			madvise(map, map_size, MADV_SEQUENTIAL);
+			if (is_gzip((const char *)map, map_size)) {
+				error = !decompress_gzip((const char *)map, map_size, -1,
+					buffer);
+				munmap(map, map_size);
+				map = nullptr;
+			}
+			return;
+		}
+		map = nullptr;
+	}
+
+	// Not a regular file, read everything. Compressed input is detected by
+	// its first bytes, and decompressed as it is read.
+	size_t size = 0;
+	bool checked = false;
+	while (true) {
+		if (size == buffer.size())
+			buffer.resize(std::max((size_t)1 << 16, 2 * size));
+		ssize_t n = ::read(fd, buffer.data() + size, buffer.size() - size);
+		if (n < 0) error = true;
+		if (n <= 0) break;
+		size += n;
+		if (!checked && size >= 2) {
+			checked = true;
+			if (is_gzip(buffer.data(), size)) {
+				std::vector<char> start(buffer.begin(), buffer.begin() + size);
+				error = !decompress_gzip(start.data(), size, fd, buffer);
+				return;
+			}
+		}
+	}
+	buffer.resize(size);
+}
+
+input_buffer::input_buffer(std::vector<char> &&data, size_t max_size)
+		: limit(max_size) {
+	if (is_gzip(data.data(), data.size()))
+		error = !decompress_gzip(data.data(), data.size(), -1, buffer,
+			limit);
+	else if (data.size() > limit)
+		error = true;
+	else
+		buffer = std::move(data);
+}
+
+input_buffer::~input_buffer() {
+	if (map != nullptr)
+		munmap(map, map_size);
+}
+
+bool input_buffer::failed() const {
+	return error;
+}
+
+const char *input_buffer::data() const {
+	return map != nullptr ? (const char *)map : buffer.data();
+}
+
+size_t input_buffer::size() const {
+	return map != nullptr ? map_size : buffer.size();
+}
+
+size_t input_buffer::max_size() const {
+	return limit;
+}
+
+matrix read_matrix(int fd) {
+	input_buffer input(fd);
+	if (input.failed())
+		return error("could not read input.");
+	return parse_matrix(input.data(), input.size());
+}
+
+matrix parse_matrix(const char *data, size_t size, size_t max_rc) {
+	const char *p = data, *end = data + size;
 	std::string line;
-	
+
 	// First line contains a typecode of the form:
 	// %%MatrixMarket matrix [coordinate|array] <...>
 	int elements = 1;		// [0, 2] (elements per index).
 	bool symmetric = false;	// Whether (i, j) implies (j, i).
 	{
-		if (!getline(stream, line))
+		if (p == end)
 			return error("no typecode found.");
+		line = next_line(p, end);
 
 		const auto &tokens = tokenize(line);
 
@@ -56,7 +231,7 @@ matrix read_matrix(std::istream &stream) {
 	}
 
 	// Consume comments (other lines starting with a '%'.
-	do { getline(stream, line); } while (line.length() > 0 && line[0] == '%');
+	do { line = next_line(p, end); } while (line.length() > 0 && line[0] == '%');
 	
 	// Retrieve matrix information. Should be `r c nz`.
 	int r = 0, c = 0, nz = 0;
@@ -64,33 +239,78 @@ matrix read_matrix(std::istream &stream) {
 		const auto &tokens = tokenize(line);
 		if (tokens.size() != 3)
 			return error("Could not find matrix dimensions/nonzeros.");
-		r = stoi(tokens[0]);
-		c = stoi(tokens[1]);
-		nz = stoi(tokens[2]);
+		if (!parse_count(tokens[0], r) || !parse_count(tokens[1], c)
+				|| !parse_count(tokens[2], nz))
+			return error("invalid matrix dimensions/nonzeros.");
+		if ((long long)r + c >= INT_MAX || (size_t)r + c > max_rc)
+			return error("matrix dimensions too large.");
 	}
 
-	// Read the nonzeros of the matrix.
-	std::vector<std::pair<int, int>> nonzeros;
-	{
-		nonzeros.reserve(nz);
-		for (int i = 0; i < nz; ++i) {
-			int j, k;
-			if (!(stream >> j >> k))
-				return error("Could not read nonzeros.");
-
-			j -= 1;
-			k -= 1;
+	// Read the nonzeros of the matrix. The remainder of the input is split
+	// into chunks at line boundaries, which are parsed in parallel.
+	int chunks = (int)std::min<size_t>(
+		std::max(1u, std::thread::hardware_concurrency()),
+		(end - p) / MIN_CHUNK + 1);
+	std::vector<const char *> bound(chunks + 1, end);
+	bound[0] = p;
+	for (int i = 1; i < chunks; ++i) {
+		const char *q = std::max(bound[i - 1], p + (end - p) / chunks * i);
+		const char *eol = (const char *)memchr(q, '\n', end - q);
+		bound[i] = eol == nullptr ? end : eol + 1;
+	}
 
-			nonzeros.push_back({j, k});
-			if (symmetric && j != k)
-				nonzeros.push_back({k, j});
+	std::vector<std::vector<std::pair<int, int>>> parts(chunks);
+	std::vector<long long> count(chunks);
+	{
+		auto parse = [&](int i) {
+			// A nonzero takes at least four bytes ("1 1\n").
+			long long expect = std::min<long long>(nz,
+				(bound[i + 1] - bound[i]) / 4 + 1);
+			parts[i].reserve((symmetric ? 2 : 1) * expect);
+			count[i] = parse_nonzeros(bound[i], bound[i + 1], elements,
+				symmetric, r, c, nz, parts[i]);
+		};
+		std::vector<std::thread> pool;
+		for (int i = 1; i < chunks; ++i)
+			pool.emplace_back(parse, i);
+		parse(0);
+		for (std::thread &t : pool) t.join();
+	}
 
-			for (int l = 0; l < elements; ++l) {
-				double val;
-				if (!(stream >> val))
-					return error("Could not read nonzeros.");
-			}
+	// Only the first nz nonzeros are used, so errors and nonzeros after
+	// those are ignored.
+	std::vector<size_t> offset(chunks + 1, 0);
+	long long total = 0;
+	for (int i = 0; i < chunks; ++i) {
+		if (total == nz) {
+			parts[i].clear();
+		} else if (count[i] < 0 || total + count[i] > nz) {
+			parts[i].clear();
+			count[i] = parse_nonzeros(bound[i], bound[i + 1], elements,
+				symmetric, r, c, nz - total, parts[i]);
+			if (count[i] == -2)
+				return error("nonzero outside the matrix.");
+			if (count[i] < 0)
+				return error("Could not read nonzeros.");
 		}
+		if (total < nz) total += count[i];
+		offset[i + 1] = offset[i] + parts[i].size();
+	}
+	if (total < nz)
+		return error("Could not read nonzeros.");
+
+	std::vector<std::pair<int, int>> nonzeros(offset[chunks]);
+	{
+		auto copy = [&](int i) {
+			std::copy(parts[i].begin(), parts[i].end(),
+				nonzeros.begin() + offset[i]);
+			std::vector<std::pair<int, int>>().swap(parts[i]);
+		};
+		std::vector<std::thread> pool;
+		for (int i = 1; i < chunks; ++i)
+			pool.emplace_back(copy, i);
+		copy(0);
+		for (std::thread &t : pool) t.join();
 	}
 	return matrix(r, c, nonzeros);
 }
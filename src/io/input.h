@@ -1,14 +1,54 @@
 #ifndef INPUT_H
 #define INPUT_H
 
-#include <iostream>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
 #include "../datastructures/matrix.h"
 
 namespace mp {
 
-// Reads a matrix in MM format.
-matrix read_matrix(std::istream &stream);
+// The complete input read from a file descriptor. Regular files are
+// memory-mapped, anything else (e.g. a pipe) is read into one buffer.
+// Gzip-compressed input (possibly a tar archive, see compressed.h) is
+// decompressed into this buffer.
+class input_buffer {
+public:
+	explicit input_buffer(int fd);
+	// Input that was already read, e.g. from a socket. Fails if it holds
+	// more than max_size bytes once decompressed.
+	explicit input_buffer(std::vector<char> &&data,
+		size_t max_size = SIZE_MAX);
+	~input_buffer();
+	input_buffer(const input_buffer &) = delete;
+	input_buffer &operator=(const input_buffer &) = delete;
+
+	// Whether reading the input failed.
+	bool failed() const;
+
+	const char *data() const;
+	size_t size() const;
+
+	// The max_size given (if any), which also bounds the rows plus columns
+	// of the matrix parsed from this input.
+	size_t max_size() const;
+
+private:
+	void *map = nullptr;
+	size_t map_size = 0;
+	std::vector<char> buffer;
+	bool error = false;
+	size_t limit = SIZE_MAX;
+};
+
+// Reads a matrix in MM format from the given file descriptor.
+matrix read_matrix(int fd);
+
+// Parses a matrix in MM format from the given buffer. The nonzeros of large
+// matrices are parsed in parallel. Matrices with more than max_rc rows plus
+// columns, or nonzeros outside their dimensions, are rejected.
+matrix parse_matrix(const char *data, size_t size, size_t max_rc = SIZE_MAX);
 
 }
 
@@ -4,6 +4,11 @@
 
 namespace mp {
 
+std::mutex &debug_lock() {
+	static std::mutex lock;
+	return lock;
+}
+
 void print_matrix(std::ostream &stream, const matrix &m) {
 	for (int r = 0; r < m.R; ++r) {
 		const auto &row = m[r];
@@ -18,55 +23,159 @@ void print_matrix(std::ostream &stream, const matrix &m) {
 	}
 }
 
+namespace {
+
+// Formats output into a large buffer, which is written out in blocks.
+class block_writer {
+public:
+	explicit block_writer(std::ostream &_stream)
+		: stream(_stream), buffer(BLOCK) {}
+	~block_writer() { flush(); }
+
+	void put(char ch) {
+		if (used == BLOCK) flush();
+		buffer[used++] = ch;
+	}
+	void put(const std::string &s) {
+		for (char ch : s) put(ch);
+	}
+	void put(long long value) {
+		char digits[24];
+		int n = 0;
+		bool negative = value < 0;
+		unsigned long long v = negative ? -(unsigned long long)value : value;
+		do { digits[n++] = (char)('0' + v % 10); v /= 10; } while (v > 0);
+		if (negative) digits[n++] = '-';
+		if (used + n > BLOCK) flush();
+		while (n > 0) buffer[used++] = digits[--n];
+	}
+
+	void flush() {
+		stream.write(buffer.data(), used);
+		used = 0;
+	}
+
+private:
+	static constexpr size_t BLOCK = 1 << 20;
+	std::ostream &stream;
+	std::vector<char> buffer;
+	size_t used = 0;
+};
+
+// The value of a nonzero with the given row and column status.
+inline char mm_value(status r, status c) {
+	if (r == status::red || c == status::red)
+		return '1';
+	else if (r == status::blue || c == status::blue)
+		return '2';
+	else
+		return '3';
+}
+
+void print_mm_header(block_writer &out, int R, int C, int NZ,
+		const std::string &comment = "") {
+	out.put("%%MatrixMarket matrix coordinate integer general\n");
+	if (!comment.empty()) {
+		out.put('%');
+		out.put(comment);
+		out.put('\n');
+	}
+	out.put((long long)R);
+	out.put(' ');
+	out.put((long long)C);
+	out.put(' ');
+	out.put((long long)NZ);
+	out.put('\n');
+}
+
+}
+
 void print_partitioned_compressed_mm(std::ostream &stream, const matrix &m,
-		std::unordered_map<int, int> &idm, std::vector<status> &row,
+		const std::vector<int> &idm, std::vector<status> &row,
 		std::vector<status> &col) {
-	stream << "%%MatrixMarket matrix coordinate integer general" << std::endl;
-	stream << m.R << ' ' << m.C << ' ' << m.NZ << std::endl;
+	block_writer out(stream);
+	print_mm_header(out, m.R, m.C, m.NZ);
 	for (int r = 0; r < m.R; ++r) {
-		const auto &rw = m[r];
-		for (const auto &e : rw) {
-			int c = e.rc - m.R;
-			stream << r+1 << ' ' << c+1 << ' ';
-			if (row[idm[r]] == status::red ||
-				col[idm[c+m.R]-(int)row.size()] == status::red)
-				stream << "1\n";
-			else if (row[idm[r]] == status::blue ||
-				col[idm[c+m.R]-(int)row.size()] == status::blue)
-				stream << "2\n";
-			else
-				stream << "3\n";
+		if (m[r].empty()) continue;
+		status rs = row[idm[r]];
+		for (const auto &e : m[r]) {
+			out.put((long long)r+1);
+			out.put(' ');
+			out.put((long long)e.rc-m.R+1);
+			out.put(' ');
+			out.put(mm_value(rs, col[idm[e.rc]-(int)row.size()]));
+			out.put('\n');
+		}
+	}
+	out.flush();
+	stream << std::flush;
+}
+
+void print_partitioned_mm(std::ostream &stream, const matrix &m,
+		const int *ids, int R, int C, std::vector<status> &row,
+		std::vector<status> &col) {
+	// Compression preserves the order of the rows and columns.
+	block_writer out(stream);
+	print_mm_header(out, R, C, m.NZ);
+	for (int r = 0; r < m.R; ++r) {
+		for (const auto &e : m[r]) {
+			out.put((long long)ids[r]+1);
+			out.put(' ');
+			out.put((long long)ids[e.rc]-R+1);
+			out.put(' ');
+			out.put(mm_value(row[r], col[e.rc-m.R]));
+			out.put('\n');
+		}
+	}
+	out.flush();
+	stream << std::flush;
+}
+
+void print_kway_mm(std::ostream &stream, const matrix &m, const int *ids,
+		int R, int C, const std::vector<int> &part, int parts, int volume) {
+	block_writer out(stream);
+	print_mm_header(out, R, C, m.NZ, " " + std::to_string(parts)
+		+ " parts, volume " + std::to_string(volume));
+	for (int r = 0, i = 0; r < m.R; ++r) {
+		for (const auto &e : m[r]) {
+			out.put((long long)ids[r]+1);
+			out.put(' ');
+			out.put((long long)ids[e.rc]-R+1);
+			out.put(' ');
+			out.put((long long)part[i++]+1);
+			out.put('\n');
 		}
 	}
+	out.flush();
 	stream << std::flush;
 }
 
 void print_partitioned_compressed_matrix(std::ostream &stream, const matrix &m,
-		std::unordered_map<int, int> &idm, std::vector<status> &row,
+		const std::vector<int> &idm, std::vector<status> &row,
 		std::vector<status> &col) {
 	stream << "  ";
 	for (int c = 0; c < m.C; ++c) {
-		auto it = idm.find(m.R+c);
-		if (it == idm.end())
+		int id = idm[m.R+c];
+		if (id < 0)
 			stream << IO_NONE_TEXT << '-';
-		else if (col[it->second-(int)row.size()] == status::cut)
+		else if (col[id-(int)row.size()] == status::cut)
 			stream << IO_YELLOW_TEXT << 'C';
-		else if (col[it->second-(int)row.size()] == status::red)
+		else if (col[id-(int)row.size()] == status::red)
 			stream << IO_RED_TEXT << 'R';
 		else
 			stream << IO_BLUE_TEXT << 'B';
 	}
 	stream << IO_NONE_TEXT << '\n';
 	for (int r = 0; r < m.R; ++r) {
-		auto it = idm.find(r);
-		if (it == idm.end()) {
+		int id = idm[r];
+		if (id < 0) {
 			stream << IO_NONE_TEXT << "- "
 				<< std::string(m.C, ZERO) << '\n';
 			continue;
 		}
-		else if (row[it->second] == status::cut)
+		else if (row[id] == status::cut)
 			stream << IO_YELLOW_TEXT << "C ";
-		else if (row[it->second] == status::red)
+		else if (row[id] == status::red)
 			stream << IO_RED_TEXT << "R ";
 		else
 			stream << IO_BLUE_TEXT << "B ";
@@ -75,10 +184,10 @@ void print_partitioned_compressed_matrix(std::ostream &stream, const matrix &m,
 		for (int c = 0; c < m.C; ++c) {
 			if (e < rw.size() && m.R + c == rw[e].rc) {
 				++e;
-				if (row[it->second] == status::red ||
+				if (row[id] == status::red ||
 					col[idm[c+m.R]-(int)row.size()] == status::red)
 					stream << IO_RED_TEXT;
-				else if (row[it->second] == status::blue ||
+				else if (row[id] == status::blue ||
 					col[idm[c+m.R]-(int)row.size()] == status::blue)
 					stream << IO_BLUE_TEXT;
 				else
@@ -2,7 +2,9 @@
 #define OUTPUT_H
 
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "../bb/partial-partition.h"
 #include "../datastructures/matrix.h"
@@ -17,17 +19,36 @@ const std::string
 	IO_NONE_TEXT = "\033[39m";
 const char ZERO = '.', NONZERO = '#';
 
+// Lock to hold while writing debug output from concurrent searches. We detach
+// from C I/O, so std::cerr itself is not synchronized.
+std::mutex &debug_lock();
+
 // Print a matrix as a grid.
 void print_matrix(std::ostream &stream, const matrix &m);
 
-// Print a partitioned and compressed matrix in MM format.
+// Print a partitioned and compressed matrix in MM format. Input the
+// *uncompressed* matrix, and idm as given by compress.
 void print_partitioned_compressed_mm(std::ostream &stream, const matrix &m,
-	std::unordered_map<int, int> &idm, std::vector<status> &row,
+	const std::vector<int> &idm, std::vector<status> &row,
+	std::vector<status> &col);
+
+// Print a partitioned matrix in MM format, given the compressed matrix and
+// the row/column of the uncompressed R x C matrix each of its rows/columns
+// came from. The output is the same as above.
+void print_partitioned_mm(std::ostream &stream, const matrix &m,
+	const int *ids, int R, int C, std::vector<status> &row,
 	std::vector<status> &col);
 
+// Print a matrix partitioned into parts parts in MM format, given the
+// compressed matrix and ids as above, and the part of every nonzero (row by
+// row, see kway.h). Parts are numbered from 1, and the volume is given in a
+// comment.
+void print_kway_mm(std::ostream &stream, const matrix &m, const int *ids,
+	int R, int C, const std::vector<int> &part, int parts, int volume);
+
 // Print a partitioned and compressed matrix. Input the *uncompressed* matrix.
 void print_partitioned_compressed_matrix(std::ostream &stream, const matrix &m,
-	std::unordered_map<int, int> &idm, std::vector<status> &row,
+	const std::vector<int> &idm, std::vector<status> &row,
 	std::vector<status> &col);
 
 // Print a ppmatrix for debugging.
@@ -0,0 +1,48 @@
+#ifndef MP_C_H
+#define MP_C_H
+
+/* Plain C interface to the partitioner, see mp.h for details. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Parameters of the branch and bound search, see bb-parameters.h. Booleans
+   are nonzero for true, order is 0 (degree), 1 (shuffled degree) or 2
+   (random). */
+typedef struct {
+	int pb, epb, mb, fb;
+	int U0;
+	float Uf;
+	int order;
+	unsigned seed;
+} mp_parameters;
+
+typedef struct {
+	int volume;
+	int lower_bound;
+	long long nodes;
+} mp_stats;
+
+/* Results of mp_partition_csr. */
+enum {
+	MP_OPTIMAL = 0, MP_TIMEOUT = 1, MP_FAILED = 2, MP_INVALID = 3
+};
+
+/* The parameters mp uses by default. */
+void mp_default_parameters(mp_parameters *param);
+
+/* Bipartition the R x C matrix in CSR format given by row_ptr and col_idx
+   (0-based, borrowed). Unless the result is MP_FAILED or MP_INVALID,
+   row_side[0, R) and col_side[0, C) are set to 0 or 1 for a side, 2 for cut,
+   or 3 for an empty row/column. param (for the defaults) and stats may be
+   NULL. */
+int mp_partition_csr(int R, int C, const int *row_ptr, const int *col_idx,
+	const mp_parameters *param, int threads, float epsilon, long long tl,
+	unsigned char *row_side, unsigned char *col_side, mp_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,126 @@
+#include "./mp.h"
+#include "./mp-c.h"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "../bb/bb-partitioner.h"
+#include "../bb/bb-portfolio.h"
+#include "../bb/incumbent.h"
+#include "../datastructures/matrix.h"
+#include "../partitioner/partition-util.h"
+
+namespace mp {
+
+namespace {
+
+// Whether A is valid CSR: row_ptr starts at 0 and never decreases, and every
+// row holds distinct columns in [0, C).
+bool valid_csr(const csr_matrix &A) {
+	if (A.R < 0 || A.C < 0 || !A.row_ptr || A.row_ptr[0] != 0
+			|| (A.row_ptr[A.R] > 0 && !A.col_idx))
+		return false;
+	std::vector<int> seen(A.C, -1);
+	for (int r = 0; r < A.R; ++r) {
+		if (A.row_ptr[r + 1] < A.row_ptr[r])
+			return false;
+		for (int i = A.row_ptr[r]; i < A.row_ptr[r + 1]; ++i) {
+			int c = A.col_idx[i];
+			if (c < 0 || c >= A.C || seen[c] == r)
+				return false;
+			seen[c] = r;
+		}
+	}
+	return true;
+}
+
+}
+
+partition_result partition_csr(const csr_matrix &A, bbparameters param,
+		int threads, float epsilon, long long tl, uint8_t *row_side,
+		uint8_t *col_side, partition_stats *stats) {
+	if (stats) *stats = partition_stats();
+	if (!valid_csr(A))
+		return partition_result::invalid;
+	if (!param.valid().first || threads < 1)
+		return partition_result::failed;
+
+	std::vector<int> ids;
+	matrix m(A.R, A.C, A.row_ptr, A.col_idx, ids);
+	std::fill(row_side, row_side + A.R, (uint8_t)part_side::empty);
+	std::fill(col_side, col_side + A.C, (uint8_t)part_side::empty);
+	if (2 * max_partition_size(m.NZ, epsilon) < m.NZ)
+		return partition_result::failed;
+
+	incumbent best(m.R + m.C, std::min(m.R, m.C) + 2);
+	auto deadline = tl > 0
+		? std::chrono::steady_clock::now() + std::chrono::seconds(tl)
+		: std::chrono::steady_clock::time_point::max();
+	bbpartitioner bb(param, threads);
+	int value = bb.run(m, epsilon, deadline, best);
+
+	std::vector<status> s;
+	best.retrieve(s);
+	int volume = 0;
+	for (size_t i = 0; i < s.size(); ++i) {
+		int rc = ids[i];
+		if (rc < A.R) row_side[rc] = (uint8_t)to_part_side(s[i]);
+		else col_side[rc - A.R] = (uint8_t)to_part_side(s[i]);
+		volume += s[i] == status::cut;
+	}
+	if (stats) {
+		stats->volume = volume;
+		stats->lower_bound = value >= 0 ? value : best.lower_bound();
+		stats->nodes = bb.nodes();
+	}
+	return value >= 0 ? partition_result::optimal : partition_result::timeout;
+}
+
+}
+
+extern "C" {
+
+void mp_default_parameters(mp_parameters *param) {
+	const mp::bbparameters p = mp::bbportfolio::default_configurations(1)[0];
+	param->pb = p.pb;
+	param->epb = p.epb;
+	param->mb = p.mb;
+	param->fb = p.fb;
+	param->U0 = p.U0;
+	param->Uf = p.Uf;
+	param->order = (int)p.order;
+	param->seed = p.seed;
+}
+
+int mp_partition_csr(int R, int C, const int *row_ptr, const int *col_idx,
+		const mp_parameters *param, int threads, float epsilon, long long tl,
+		unsigned char *row_side, unsigned char *col_side, mp_stats *stats) {
+	mp_parameters defaults;
+	if (!param) {
+		mp_default_parameters(&defaults);
+		param = &defaults;
+	}
+	if (param->order < 0 || param->order > (int)mp::branch_order::random)
+		return MP_FAILED;
+	mp::bbparameters p(param->pb != 0, param->epb != 0, param->mb != 0,
+		param->fb != 0, param->U0, param->Uf,
+		(mp::branch_order)param->order, param->seed);
+
+	mp::partition_stats st;
+	mp::partition_result result = mp::partition_csr({R, C, row_ptr, col_idx},
+		p, threads, epsilon, tl, row_side, col_side, &st);
+	if (stats) {
+		stats->volume = st.volume;
+		stats->lower_bound = st.lower_bound;
+		stats->nodes = st.nodes;
+	}
+	switch (result) {
+		case mp::partition_result::optimal: return MP_OPTIMAL;
+		case mp::partition_result::timeout: return MP_TIMEOUT;
+		case mp::partition_result::failed: return MP_FAILED;
+		default: return MP_INVALID;
+	}
+}
+
+}
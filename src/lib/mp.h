@@ -0,0 +1,44 @@
+#ifndef MP_H
+#define MP_H
+
+#include <cstdint>
+
+#include "../bb/bb-parameters.h"
+#include "../partitioner/partition-util.h"
+
+namespace mp {
+
+// A matrix in CSR format, borrowed from the caller: row r has nonzeros in
+// the columns col_idx[row_ptr[r]], ..., col_idx[row_ptr[r + 1] - 1]. Column
+// indices are 0-based, and may appear at most once per row.
+struct csr_matrix {
+	int R, C;
+	const int *row_ptr;
+	const int *col_idx;
+};
+
+enum class partition_result {
+	optimal,	// The partitioning is optimal.
+	timeout,	// Out of time, the partitioning is the best found.
+	failed,		// No partitioning exists with this eps, or param is invalid.
+	invalid		// The matrix is not valid CSR.
+};
+
+struct partition_stats {
+	int volume = -1;
+	int lower_bound = 0;
+	long long nodes = 0;
+};
+
+// Bipartition A with a bbpartitioner using param and the given number of
+// threads, with load imbalance epsilon and time limit tl (in seconds, 0 for
+// none). Unless the result is failed or invalid, row_side[0, R) and
+// col_side[0, C) are filled in with a part_side each. The CSR arrays are read
+// directly, only the matrix layout used by the solver is built from them.
+partition_result partition_csr(const csr_matrix &A, bbparameters param,
+	int threads, float epsilon, long long tl, uint8_t *row_side,
+	uint8_t *col_side, partition_stats *stats = nullptr);
+
+}
+
+#endif
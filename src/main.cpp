@@ -1,30 +1,79 @@
 #include <algorithm>
+#include <cstdint>
 #include <iostream>
-#include <unordered_map>
+#include <memory>
+#include <string>
 #include <vector>
 
+#include <unistd.h>
+
 #include "bb/bb-parameters.h"
 #include "bb/bb-partitioner.h"
-#include "io/input.h"
+#include "bb/bb-portfolio.h"
+#include "driver/batch.h"
+#include "driver/cache.h"
+#include "driver/kway.h"
+#include "driver/problem.h"
+#include "driver/server.h"
+#include "io/binary.h"
 #include "io/output.h"
 #include "datastructures/matrix.h"
-#include "datastructures/matrix-util.h"
 #include "partitioner/partition-util.h"
 
 constexpr float eps_default = 0.03f;
 constexpr long long timelimit_default = 0LL;
+constexpr long long threads_default = 1LL;
+constexpr long long portfolio_default = 0LL;
+constexpr long long parallel_default = 1LL;
+constexpr long long parts_default = 0LL;
+constexpr long long max_request_default = 1024LL;
 constexpr char help_text[] = "\
  MP - Matrix Partitioner\n\n\
  Usage:\
-\t./mp [-e eps] [-t tl] <input >output 2>debug\n\n\
- The program reads a matrix in MatrixMarket format\n\
- from stdin and writes the solution to stdout. Debug\n\
- is written to stderr.\n\n\
+\t./mp [-e eps] [-t tl] [-j N] [-P n] [-c dir] <input >output 2>debug\n\
+\t./mp -p k [-e eps] [-t tl] [-B K] [...] <input >output\n\
+\t./mp -w file <input\n\
+\t./mp --batch <list|dir> [-B K] [-o dir] [...]\n\
+\t./mp --serve socket [-B K] [-j N] [-M mb]\n\n\
+ The program reads a matrix in MatrixMarket (or mp's\n\
+ binary) format from stdin and writes the solution to\n\
+ stdout. Debug is written to stderr.\n\n\
  Flags:\n\
 \t-e eps\tMaximum tolerated load imbalance.\n\
 \t\tDefaults to 0.03.\n\
 \t-t tl\tTimelimit, in seconds. Defaults to\n\
-\t\t0 for no limit.";
+\t\t0 for no limit.\n\
+\t-j N\tNumber of threads used for the search.\n\
+\t\tDefaults to 1.\n\
+\t-P n\tRace a portfolio of n solver configurations\n\
+\t\t(each using N threads). Defaults to 0\n\
+\t\tfor a single configuration.\n\
+\t-c dir\tCache results in dir. Matrices solved\n\
+\t\tbefore (up to row/column order) are\n\
+\t\tanswered from the cache, or resumed from\n\
+\t\tthe bounds found before.\n\
+\t-p k\tPartition into k parts (a power of two)\n\
+\t\tby recursive bisection. The value of a\n\
+\t\tnonzero in the output is its part, and\n\
+\t\tthe timelimit holds per bisection.\n\
+\t-w file\tWrite the compressed matrix to file in\n\
+\t\tbinary format, which loads much faster,\n\
+\t\tinstead of partitioning it.\n\
+\t--batch list|dir\n\
+\t\tPartition every matrix in dir, or listed\n\
+\t\tin list as lines 'path [eps [tl]]', and\n\
+\t\tprint a summary table to stdout.\n\
+\t-B K\tNumber of matrices partitioned at the same\n\
+\t\ttime in batch mode, or of bisections\n\
+\t\twith -p. Defaults to 1.\n\
+\t-o dir\tWrite the partitioned matrices of a batch\n\
+\t\tto dir/NAME.mtx.\n\
+\t--serve socket\n\
+\t\tListen for requests on a Unix domain\n\
+\t\tsocket (see driver/server.h), solving up\n\
+\t\tto K (-B) of them at the same time.\n\
+\t-M mb\tLargest matrix accepted by the server, in\n\
+\t\tMiB. Defaults to 1024.";
 
 // Very simple argument parser. Deals with errors
 // by ignoring them.
@@ -44,6 +93,13 @@ struct cmd_args {
 		else
 			return stof(*it);
 	}
+	std::string get_string(const std::string &f, const std::string &def) {
+		auto it = std::find(args.begin(), args.end(), f);
+		if (it == args.end() || (++it) == args.end())
+			return def;
+		else
+			return *it;
+	}
 	long long get_ll(const std::string &f, long long def) {
 		auto it = std::find(args.begin(), args.end(), f);
 		if (it == args.end() || (++it) == args.end())
@@ -66,38 +122,121 @@ int main(int argc, char** argv) {
 	}
 	float eps = args.get_float("-e", eps_default);
 	long long timelimit = args.get_ll("-t", timelimit_default);
-	std::cerr << "Running with eps=" << eps << ", and TL="
-		<< timelimit << std::endl;
+	int threads = (int)args.get_ll("-j", threads_default);
+	int portfolio = (int)args.get_ll("-P", portfolio_default);
+	std::cerr << "Running with eps=" << eps << ", TL=" << timelimit
+		<< ", and " << threads << " thread(s)" << std::endl;
+
+	const mp::bbparameters param{
+		true,		// packing bound
+		true,		// extended packing bound
+		false,		// matching bound
+		true,		// flow bound
+		1,			// initial upperbound
+		1.25f		// scaling factor
+	};
+	std::string cache = args.get_string("-c", "");
+	auto make_partitioner = [&]() -> std::unique_ptr<mp::partitioner> {
+		std::unique_ptr<mp::partitioner> part;
+		if (portfolio > 0) {
+			part.reset(new mp::bbportfolio(
+				mp::bbportfolio::default_configurations(portfolio), threads));
+		} else {
+			part.reset(new mp::bbpartitioner(param, threads));
+		}
+		if (!cache.empty())
+			part.reset(new mp::cached_partitioner(cache, std::move(part)));
+		return part;
+	};
+
+	std::string socket_path = args.get_string("--serve", "");
+	if (!socket_path.empty()) {
+		uint64_t max_request = std::max(0LL,
+			args.get_ll("-M", max_request_default));
+		return mp::run_server(socket_path, param, threads,
+			(int)args.get_ll("-B", parallel_default), max_request << 20)
+			? 0 : 1;
+	}
+
+	std::string batch = args.get_string("--batch", "");
+	if (!batch.empty()) {
+		std::vector<mp::batch_job> jobs;
+		if (!mp::read_batch_jobs(batch, eps, timelimit, jobs)) {
+			std::cerr << "Could not read " << batch << std::endl;
+			return 1;
+		}
+		mp::batch_options opt;
+		opt.parallel = (int)args.get_ll("-B", parallel_default);
+		opt.outdir = args.get_string("-o", "");
+		opt.make_partitioner = make_partitioner;
+		std::cerr << "Partitioning " << jobs.size() << " matrices, "
+			<< opt.parallel << " at a time." << std::endl;
+		mp::run_batch(jobs, opt, std::cout);
+		return 0;
+	}
 
 	// Read matrix.
-	mp::matrix mat = mp::read_matrix(std::cin);
+	mp::problem p;
+	if (!mp::load_problem(STDIN_FILENO, p)) {
+		std::cerr << "Error reading input." << std::endl;
+		return 1;
+	}
+	const mp::matrix &cmat = p.m;
 
-	// Compress.
-	std::unordered_map<int, int> idm;
-	mp::matrix cmat = mp::compress(mat, idm);
+	std::string binary = args.get_string("-w", "");
+	if (!binary.empty()) {
+		if (!mp::write_binary_matrix(binary, cmat, p.ids, p.R, p.C)) {
+			std::cerr << "Could not write " << binary << std::endl;
+			return 1;
+		}
+		std::cerr << "Wrote " << cmat.R << 'x' << cmat.C << " matrix with "
+			<< cmat.NZ << " nonzeros to " << binary << std::endl;
+		return 0;
+	}
 
 	std::cerr << "Read " << cmat.R << 'x' << cmat.C << " matrix with "
 		<< cmat.NZ << " nonzeros (after compression)" << std::endl;
 	std::cerr << "Attempting partitioning with eps=" << eps << " in ";
 	std::cerr << timelimit << " seconds." << std::endl;
 
-	mp::bbpartitioner bb(mp::bbparameters{
-		true,		// packing bound
-		true,		// extended packing bound
-		false,		// matching bound
-		true,		// flow bound
-		1,			// initial upperbound
-		1.25f		// scaling factor
-	});
+	int parts = (int)args.get_ll("-p", parts_default);
+	if (parts > 0) {
+		mp::kway_options opt;
+		opt.parts = parts;
+		opt.parallel = (int)args.get_ll("-B", parallel_default);
+		opt.make_partitioner = make_partitioner;
+		mp::kway_result result;
+		if (!mp::partition_kway(cmat, eps, timelimit, opt, result)) {
+			std::cerr << "Partitioning into " << parts << " parts failed."
+				<< std::endl;
+			return 1;
+		}
+		std::cerr << "Partitioned into " << parts << " parts with volume "
+			<< result.volume << (result.optimal ? ", every bisection optimal."
+				: ", not every bisection optimal.") << std::endl;
+		mp::print_kway_mm(std::cout, cmat, p.ids.data(), p.R, p.C,
+			result.part, parts, result.volume);
+		return 0;
+	}
+
+	if (portfolio > 0) {
+		std::cerr << "Racing a portfolio of " << portfolio
+			<< " configurations." << std::endl;
+	}
+	std::unique_ptr<mp::partitioner> bb = make_partitioner();
 	std::vector<mp::status> rowstat, colstat;
-	if (bb.partition(cmat, rowstat, colstat, eps, timelimit)) {
+	auto print = [&]() {
+		mp::print_partitioned_mm(std::cout, cmat, p.ids.data(), p.R, p.C,
+			rowstat, colstat);
+	};
+	if (bb->partition(cmat, rowstat, colstat, eps, timelimit)) {
 		std::cerr << "Partitioning succesful, printing to stdout now." << std::endl;
-		mp::print_partitioned_compressed_mm(std::cout, mat, idm, rowstat, colstat);
+		print();
 	} else {
 		std::cerr << "Partitioning unsuccesful within timelimit." << std::endl;
 		if (!rowstat.empty() && rowstat[0] != mp::status::unassigned) {
 			std::cerr << "Got partitioning anyway, printing." << std::endl;
-			mp::print_partitioned_compressed_mm(std::cout, mat, idm, rowstat, colstat);
+			print();
 		}
 	}
 
@@ -1,6 +1,8 @@
 #ifndef PARTITION_UTIL_H
 #define PARTITION_UTIL_H
 
+#include <cstdint>
+
 #include "../datastructures/matrix-util.h"
 
 namespace mp {
@@ -11,6 +13,24 @@ enum status {
 	partial_red = 4, partial_blue = 5, implicitly_cut = 6
 };
 
+// The maximal number of nonzeros in any part of a partitioning of NZ nonzeros
+// into parts parts (a bipartitioning by default) with load imbalance epsilon.
+inline int max_partition_size(int NZ, float epsilon, int parts = 2) {
+	return static_cast<int>((1.0f + epsilon) * ((NZ + parts - 1) / parts));
+}
+
+// The side of a row or column of a bipartitioning, as reported outside the
+// solver (by the server and the library). Nonzeros in a row or column on a
+// side go to that side. Empty rows and columns may go anywhere.
+enum class part_side : uint8_t { first = 0, second = 1, cut = 2, empty = 3 };
+
+inline part_side to_part_side(status s) {
+	if (s == status::red) return part_side::first;
+	if (s == status::blue) return part_side::second;
+	if (s == status::cut) return part_side::cut;
+	return part_side::empty;
+}
+
 inline status to_partial(status s) {
 	if (s == status::red) return status::partial_red;
 	if (s == status::blue) return status::partial_blue;
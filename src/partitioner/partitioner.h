@@ -18,6 +18,17 @@ class partitioner {
 	virtual bool partition(const matrix &m, std::vector<status> &row,
 		std::vector<status> &col, float epsilon, long long tl) = 0;
 
+	// Number of branch and bound nodes explored by the last call to
+	// partition, if the partitioner branches at all.
+	virtual long long nodes() const { return 0; }
+
+	// Lower bound on the volume proven by the last call to partition.
+	virtual int lower_bound() const { return 0; }
+
+	// Start the next call to partition from a known partitioning (statuses
+	// of the rows, then the columns, or empty) and a proven lower bound.
+	virtual void warm_start(const std::vector<status> &s, int lb) { }
+
 	virtual ~partitioner() {};
 };
 
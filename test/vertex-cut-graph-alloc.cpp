@@ -0,0 +1,88 @@
+// Checks that the vertex cut graph maintains its flow without heap
+// allocations: once it is built, set_activity and rollback (which undoes
+// assignments during the branch and bound) may not call operator new.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "../src/datastructures/matrix.h"
+#include "../src/datastructures/vertex-cut-graph.h"
+
+static long long allocations = 0;
+
+void *operator new(size_t size) {
+	++allocations;
+	void *p = malloc(size > 0 ? size : 1);
+	if (p == nullptr) throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void *p) noexcept {
+	free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+	free(p);
+}
+
+using namespace mp;
+
+constexpr int R = 60, C = 50, PER_ROW = 4, ROUNDS = 2000;
+
+int main() {
+	// A random matrix, with PER_ROW distinct columns in every row.
+	std::mt19937 rng(1);
+	std::vector<std::pair<int, int>> nonzeros;
+	std::vector<int> seen(C, -1);
+	for (int r = 0; r < R; ++r) {
+		for (int k = 0; k < PER_ROW; ) {
+			int c = (int)(rng() % C);
+			if (seen[c] == r) continue;
+			seen[c] = r;
+			nonzeros.push_back({r, c});
+			++k;
+		}
+	}
+	matrix m(R, C, nonzeros);
+	vertex_cut_graph vcg(m);
+
+	std::vector<int> order(m.R + m.C), frames;
+	std::iota(order.begin(), order.end(), 0);
+	std::shuffle(order.begin(), order.end(), rng);
+	frames.reserve(order.size());
+	const vertex_state states[] = {vertex_state::source, vertex_state::sink,
+		vertex_state::inactive};
+
+	// Walk down paths of a B&B tree: assign a state to every row/column in
+	// turn, then backtrack to a random depth and continue in another order.
+	long long calls = 0;
+	allocations = 0;
+	for (int round = 0; round < ROUNDS; ++round) {
+		while (frames.size() < order.size()) {
+			frames.push_back(vcg.checkpoint());
+			vcg.set_activity(order[frames.size() - 1], states[rng() % 3]);
+			++calls;
+		}
+		size_t depth = rng() % order.size();
+		vcg.rollback(frames[depth]);
+		frames.resize(depth);
+		std::shuffle(order.begin() + depth, order.end(), rng);
+	}
+	long long counted = allocations;
+
+	if (!frames.empty()) vcg.rollback(frames[0]);
+	bool restored = vcg.get_minimum_vertex_cut() == 0;
+
+	printf("%lld set_activity calls, %lld allocations\n", calls, counted);
+	if (counted > 0 || !restored) {
+		printf("FAILED%s\n", restored ? "" : ": flow left after rollback");
+		return 1;
+	}
+	return 0;
+}
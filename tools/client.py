@@ -0,0 +1,69 @@
+#!/usr/bin/python3
+
+import socket
+import struct
+import sys
+
+# See src/driver/server.h for the protocol. Integers are in native byte order.
+REQUEST = struct.Struct('=4sIQfIQ')
+RESPONSE = struct.Struct('=4sIQqdQiiii')
+PARTITION, CANCEL = 0, 1
+RESULTS = ['optimal', 'timeout', 'cancelled', 'failed', 'invalid']
+
+def recv_exactly(sock, size):
+	data = b''
+	while len(data) < size:
+		chunk = sock.recv(size - len(data))
+		if not chunk:
+			raise ConnectionError("Server closed the connection.")
+		data += chunk
+	return data
+
+def send_request(sock, id, matrix, eps=0.03, deadline_ms=0):
+	""" Sends a partition request for the matrix (bytes in any format mp
+		reads). """
+	sock.sendall(REQUEST.pack(b'MPRQ', PARTITION, id, eps, deadline_ms,
+		len(matrix)) + matrix)
+
+def send_cancel(sock, id):
+	sock.sendall(REQUEST.pack(b'MPRQ', CANCEL, id, 0.0, 0, 0))
+
+def read_response(sock):
+	""" Reads a response. Returns (id, result, volume, nodes, seconds,
+		statuses), with statuses the side of every row and then every column
+		(0 and 1 for the sides, 2 for cut and 3 for empty), or None. """
+	magic, result, id, nodes, seconds, size, volume, R, C, _ = \
+		RESPONSE.unpack(recv_exactly(sock, RESPONSE.size))
+	if magic != b'MPRS':
+		raise ValueError("Invalid response.")
+	statuses = recv_exactly(sock, size) if size > 0 else None
+	return id, RESULTS[result], volume, nodes, seconds, statuses
+
+def main():
+	if len(sys.argv) < 3:
+		raise ValueError("Give the socket and one or more matrices as "
+			"arguments, optionally followed by -e eps and -t deadline_ms.")
+	args = sys.argv[2:]
+	eps, deadline_ms = 0.03, 0
+	if '-e' in args:
+		i = args.index('-e')
+		eps = float(args[i + 1])
+		del args[i:i + 2]
+	if '-t' in args:
+		i = args.index('-t')
+		deadline_ms = int(args[i + 1])
+		del args[i:i + 2]
+
+	sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+	sock.connect(sys.argv[1])
+	for id, filename in enumerate(args):
+		with open(filename, 'rb') as f:
+			send_request(sock, id, f.read(), eps, deadline_ms)
+	for _ in args:
+		id, result, volume, nodes, seconds, _ = read_response(sock)
+		print(str.format("{}: {}, volume {}, {} nodes, {:.3f} seconds",
+			args[id], result, volume, nodes, seconds))
+	sock.close()
+
+if __name__ == "__main__":
+	main()
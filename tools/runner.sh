@@ -18,9 +18,9 @@ declare -a SOLVER=("./mp1", "./mp2")
 ## Consider all matrices (zipped as .tar.gz) in this directory
 ## (recursively). We assume the matrices are downloaded from
 ## the Suite Sparse Matrix Collection (sparse.tamu.edu) and
-## therefore consiste of a file NAME.tar.gz containing only
-## NAME/NAME.mtx. For other formats, the code below should
-## be trivial to rewrite.
+## therefore consiste of a file NAME.tar.gz containing
+## NAME/NAME.mtx, which mp reads directly. For other formats,
+## the code below should be trivial to rewrite.
 DIR=tars/
 
 ## Timelimit for every matrix (in seconds) and epsilon.
@@ -36,10 +36,9 @@ SOL=false
 
 echo "Run '${NAME}', with TL=${TL}, EPS=${EPS}."
 
-# Make a directory to store results, and one for unzips.
+# Make a directory to store results.
 OUTDIR=runs/${NAME}
 mkdir -p ${OUTDIR}
-mkdir -p tmp
 
 # Loop over all the given matrices.
 find ${DIR} -type f -name '*.tar.gz' | while read MTX; do
@@ -48,16 +47,14 @@ find ${DIR} -type f -name '*.tar.gz' | while read MTX; do
 	MTX_NAME="${MTX_NAME%.tar.gz}"
 	echo "Considering ${MTX_NAME} at ${MTX} now."
 
-	# Unzip and run over all binaries.
-	tar xzf ${MTX} -C tmp/
-
+	# Run over all binaries, which decompress the matrix themselves.
 	for PROG in "${SOLVER[@]}"
 	do
 		# Get the name of the solver.
 		PROG_NAME=$(basename -- "${PROG}")
 
 		# stdin, stdout and stderr
-		MIN=tmp/${MTX_NAME}/${MTX_NAME}.mtx
+		MIN=${MTX}
 		MOUT=/dev/null
 		DOUT=${OUTDIR}/${MTX_NAME}__${PROG_NAME}.debug
 		if ${SOL} ; then MOUT=${OUTDIR}/${MTX_NAME}__${PROG_NAME}.mtx; fi
@@ -67,9 +64,4 @@ find ${DIR} -type f -name '*.tar.gz' | while read MTX; do
 		echo " Running '${CMD}'."
 		eval ${CMD}
 	done
-
-	# Remove the matrix again.
-	rm -r "tmp/${MTX_NAME}"
 done
-
-rm -r tmp/